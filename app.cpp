@@ -1,10 +1,12 @@
 /*
  * Main application logic for the shotStopper controller.
  *
- * This file contains the primary setup and coordination logic,
- * separating it from the Arduino-specific .ino file.
- * Now spawns a task for the initial BLE read on boot.
- * Sets initial screen brightness.
+ * app_init() brings the modules up in dependency order, marking each phase
+ * in the boot trace: persisted settings first (the screens read the presets),
+ * the shot session recorder, the display and UI at the initial brightness,
+ * the battery sampler, the encoder, BLE, Home Assistant, the boot read of the
+ * stopper, the optional per-task CPU report, memory telemetry and finally the
+ * serial console with its diagnostic commands.
  */
 
 #include "app.h"
@@ -13,10 +15,15 @@
 #include "lcd_bsp.h"
 #include "lcd_bl_pwm_bsp.h" // Include the backlight header
 #include <Arduino.h>
-#include <Preferences.h>
 #include "home_assistant.h" // Include for HA init
-
-Preferences preferences;
+#include "task_stats.h"
+#include "boot_trace.h"
+#include "ble_stats.h"
+#include "serial_console.h"
+#include "telemetry.h"
+#include "battery.h"
+#include "settings.h"
+#include "shot_session.h"
 
 // Define brightness levels (0-255 for 8-bit PWM)
 #define BRIGHTNESS_HIGH 178 // ~70% (255 * 0.7)
@@ -26,28 +33,56 @@ Preferences preferences;
 void app_init() {
     Serial.println("Initializing main application...");
 
+    // Load persisted settings first: the screen build reads the presets
+    settings_init();
+    boot_trace_mark(BOOT_MARK_NVS);
+
+    // Shot history ring and the sessions kept in flash
+    shot_session_init();
+
     // Initialize the display driver and LVGL
     lcd_lvgl_Init();
+    boot_trace_mark(BOOT_MARK_DISPLAY);
 
     // Initialize and set initial backlight brightness (70%)
     lcd_bl_pwm_bsp_init(BRIGHTNESS_HIGH);
 
+    // Battery sampling; the first reading is posted before the first frame
+    battery_init();
+
     // Initialize the rotary encoder
     encoder_init();
+    boot_trace_mark(BOOT_MARK_ENCODER);
 
     // Initialize BLE client (no scan yet)
     ble_client_init();
+    boot_trace_mark(BOOT_MARK_BLE_INIT);
 
-    // Initialize non-volatile storage
-    preferences.begin("shotStopper", false);
-
-    // Initialize Home Assistant (connects to WiFi/MQTT)
+    // Initialize Home Assistant (WiFi/MQTT come up in the background)
     ha_init();
+    boot_trace_mark(BOOT_MARK_HA_INIT);
 
-    // After all other init, create a task to perform the initial BLE read
-    // This runs in parallel and doesn't block the main setup.
+    // After all other init, schedule the initial BLE read on the BLE worker.
+    // This runs in parallel and no longer waits on the network.
     ble_perform_initial_read();
 
+    // Per-task CPU report (off unless TASK_STATS_ENABLE is set in task_config.h)
+    task_stats_init();
+
+    // Heap, stack and LVGL memory telemetry (minima survive resets)
+    telemetry_init();
+
+    // Serial diagnostics
+    serial_console_register("ble", "BLE latency histograms and counters", ble_stats_dump);
+    serial_console_register("boot", "Boot timeline", boot_trace_dump);
+    serial_console_register("tasks", "Per-task CPU since the last report", task_stats_log);
+    serial_console_register("mem", "Heap, LVGL and stack telemetry", telemetry_dump);
+    serial_console_register("settings", "Persisted settings and pending commits", settings_dump);
+    serial_console_register("shots", "Shot sessions kept in flash", shot_session_dump);
+    serial_console_register("batt", "Battery voltage and state of charge", battery_dump);
+    serial_console_init();
+
+    boot_trace_mark(BOOT_MARK_APP_INIT);
     Serial.println("Application initialization complete.");
 }
 
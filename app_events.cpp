@@ -0,0 +1,67 @@
+/*
+ * Event bus between the input, BLE, HA and UI modules.
+ *
+ * One mailbox per event type plus a pending mask, behind a spinlock so BLE
+ * (radio core) and LVGL (UI core) can post and take without a mutex. The
+ * listener (the LVGL task's wake-up) is called outside the lock.
+ */
+
+#include <Arduino.h>
+#include "app_events.h"
+
+static portMUX_TYPE events_mux = portMUX_INITIALIZER_UNLOCKED;
+static app_event_value_t pending_values[APP_EVT_COUNT];
+static uint32_t pending_mask = 0;
+static unsigned long collapsed_posts = 0;
+static app_events_listener_t events_listener = NULL;
+
+void app_events_set_listener(app_events_listener_t listener) {
+    events_listener = listener;
+}
+
+void app_events_post(app_event_type_t type, app_event_value_t value) {
+    if ((unsigned)type >= APP_EVT_COUNT) return;
+    const uint32_t bit = 1UL << type;
+
+    portENTER_CRITICAL(&events_mux);
+    if (pending_mask & bit) collapsed_posts++;
+    pending_values[type] = value;
+    pending_mask |= bit;
+    portEXIT_CRITICAL(&events_mux);
+
+    app_events_listener_t listener = events_listener;
+    if (listener) listener();
+}
+
+void app_events_post_int(app_event_type_t type, int32_t value) {
+    app_event_value_t v;
+    v.i = value;
+    app_events_post(type, v);
+}
+
+void app_events_post_float(app_event_type_t type, float value) {
+    app_event_value_t v;
+    v.f = value;
+    app_events_post(type, v);
+}
+
+void app_events_post_bool(app_event_type_t type, bool value) {
+    app_event_value_t v;
+    v.b = value;
+    app_events_post(type, v);
+}
+
+uint32_t app_events_take(app_event_value_t values[APP_EVT_COUNT]) {
+    portENTER_CRITICAL(&events_mux);
+    uint32_t mask = pending_mask;
+    for (int t = 0; t < APP_EVT_COUNT; t++) {
+        if (mask & (1UL << t)) values[t] = pending_values[t];
+    }
+    pending_mask = 0;
+    portEXIT_CRITICAL(&events_mux);
+    return mask;
+}
+
+unsigned long app_events_collapsed(void) {
+    return collapsed_posts;
+}
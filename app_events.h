@@ -1,12 +1,18 @@
 /*
  * Defines application-wide events and status types.
  *
- * This makes it easy to pass status information between different parts
- * of the application, like the BLE client and the LVGL display.
+ * A typed event bus: BLE, HA and other producers post events from their own
+ * tasks, and the LVGL task applies them once per lv_timer_handler() cycle
+ * (lvgl_display_process_events). Events are state updates, so each type
+ * keeps only its newest value; several posts between two UI cycles collapse
+ * into one widget update and the bus can never overflow.
  */
 #ifndef APP_EVENTS_H
 #define APP_EVENTS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 // Defines the possible states of the Bluetooth LE connection
 typedef enum {
     BLE_STATUS_DISCONNECTED,
@@ -15,5 +21,59 @@ typedef enum {
     BLE_STATUS_FAILED
 } ble_status_t;
 
-#endif // APP_EVENTS_H
+// Defines the possible states of the Wi-Fi / MQTT (Home Assistant) connection
+typedef enum {
+    NET_STATUS_OFFLINE,         // Wi-Fi down, waiting for the next retry
+    NET_STATUS_WIFI_CONNECTING, // Associating with the access point
+    NET_STATUS_MQTT_CONNECTING, // Wi-Fi up, broker not connected yet
+    NET_STATUS_ONLINE           // Wi-Fi and MQTT connected
+} net_status_t;
+
+// Event types. The comment names the payload member that is used.
+typedef enum {
+    APP_EVT_BLE_STATUS,          // i: ble_status_t
+    APP_EVT_NET_STATUS,          // i: net_status_t
+    APP_EVT_WEIGHT_CONFIRMED,    // i: target weight the stopper confirmed (shows the checkmark)
+    APP_EVT_WEIGHT_UNVERIFIED,   // i: weight not yet confirmed (hides the checkmark)
+    APP_EVT_BATTERY,             // i: state of charge, 0..100 (already filtered)
+    APP_EVT_HA_POWER,            // b
+    APP_EVT_HA_MODE,             // i: pre-infusion mode index
+    APP_EVT_HA_TEMPERATURE,      // f: degrees C
+    APP_EVT_HA_STEAM_POWER,      // i: 1..3
+    APP_EVT_HA_PREINFUSION_TIME, // f: seconds
+    APP_EVT_HA_LAST_SHOT,        // f: seconds
+    APP_EVT_COUNT
+} app_event_type_t;
+
+typedef union {
+    int32_t i;
+    float f;
+    bool b;
+} app_event_value_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
+// Called after every post so the consumer can schedule a cycle (any task, not ISRs)
+typedef void (*app_events_listener_t)(void);
+void app_events_set_listener(app_events_listener_t listener);
+
+// Producers: replace the pending value of that type. Safe from any task, never blocks.
+void app_events_post(app_event_type_t type, app_event_value_t value);
+void app_events_post_int(app_event_type_t type, int32_t value);
+void app_events_post_float(app_event_type_t type, float value);
+void app_events_post_bool(app_event_type_t type, bool value);
+
+// Consumer: copies out every pending value and clears them.
+// Returns a bitmask of the types that were pending (bit n = type n).
+uint32_t app_events_take(app_event_value_t values[APP_EVT_COUNT]);
+
+// Lifetime total of posts that replaced a value the consumer had not seen yet
+unsigned long app_events_collapsed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_EVENTS_H
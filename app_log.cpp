@@ -0,0 +1,79 @@
+/*
+ * Buffered, levelled logging.
+ *
+ * Lines go into an ESP-IDF no-split ring buffer with a zero timeout, so a
+ * producer only ever pays for formatting and a short copy; the UART (or USB
+ * CDC) wait is taken by the drain task. Lines still in the ring are lost on
+ * a panic, so crash diagnostics should keep using the panic handler's output.
+ */
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <freertos/ringbuf.h>
+#include "app_log.h"
+#include "task_config.h"
+
+#define APP_LOG_RING_SIZE 4096  // Bytes of pending log text
+#define APP_LOG_LINE_MAX 192    // Longer lines are truncated
+
+static RingbufHandle_t log_ring = NULL;
+static volatile unsigned long dropped_lines = 0;
+
+void app_log_write(int level, const char* fmt, ...) {
+    char line[APP_LOG_LINE_MAX];
+    const char* tag = level == APP_LOG_LEVEL_ERROR ? "E: " : level == APP_LOG_LEVEL_WARN ? "W: " : "";
+    int len = snprintf(line, sizeof(line), "[%lu] %s", millis(), tag);
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line + len, sizeof(line) - len - 1, fmt, args); // Keep room for the newline
+    va_end(args);
+    if (n < 0) return;
+    len += n;
+    if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2; // Truncated
+    line[len++] = '\n';
+
+    if (log_ring == NULL) {
+        Serial.write((const uint8_t*)line, len); // Early boot, before the drain task
+        return;
+    }
+    if (xRingbufferSend(log_ring, line, len, 0) != pdTRUE) {
+        __atomic_fetch_add(&dropped_lines, 1, __ATOMIC_RELAXED);
+    }
+}
+
+unsigned long app_log_dropped(void) {
+    return dropped_lines;
+}
+
+static void app_log_task(void* arg) {
+    unsigned long reported_drops = 0;
+    while (true) {
+        size_t size = 0;
+        char* item = (char*)xRingbufferReceive(log_ring, &size, portMAX_DELAY);
+        if (item) {
+            Serial.write((const uint8_t*)item, size);
+            vRingbufferReturnItem(log_ring, item);
+        }
+        unsigned long drops = dropped_lines;
+        if (drops != reported_drops) {
+            Serial.printf("[%lu] W: %lu log lines dropped\n", millis(), drops - reported_drops);
+            reported_drops = drops;
+        }
+    }
+}
+
+void app_log_init(void) {
+    if (log_ring) return;
+    RingbufHandle_t ring = xRingbufferCreate(APP_LOG_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (ring == NULL) {
+        Serial.println("!!! Failed to create log ring, logging stays synchronous !!!");
+        return;
+    }
+    log_ring = ring;
+    if (xTaskCreatePinnedToCore(app_log_task, "Log", LOG_TASK_STACK, NULL, LOG_TASK_PRIORITY, NULL, LOG_TASK_CORE) != pdPASS) {
+        log_ring = NULL; // Keep logging synchronously
+        vRingbufferDelete(ring);
+        Serial.println("!!! Failed to create log task !!!");
+    }
+}
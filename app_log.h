@@ -0,0 +1,66 @@
+/*
+ * Buffered, levelled logging.
+ *
+ * LOG_E/W/I/D/V format the message in the caller (with the usual "[millis] "
+ * prefix) and hand it to a ring buffer without blocking; a low-priority task
+ * drains the ring to Serial. A full ring drops the line and counts it instead
+ * of stalling the caller. Calls below APP_LOG_LEVEL compile to nothing.
+ * The format string takes no trailing newline.
+ */
+#ifndef APP_LOG_H
+#define APP_LOG_H
+
+#define APP_LOG_LEVEL_NONE    0
+#define APP_LOG_LEVEL_ERROR   1
+#define APP_LOG_LEVEL_WARN    2
+#define APP_LOG_LEVEL_INFO    3
+#define APP_LOG_LEVEL_DEBUG   4 // Per-detent / per-event traces
+#define APP_LOG_LEVEL_VERBOSE 5
+
+#ifndef APP_LOG_LEVEL
+#define APP_LOG_LEVEL APP_LOG_LEVEL_INFO
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Starts the drain task. Lines logged before this are written synchronously.
+void app_log_init(void);
+
+void app_log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Lines lost to a full ring since boot
+unsigned long app_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) app_log_write(APP_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) do { } while (0)
+#endif
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) app_log_write(APP_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) do { } while (0)
+#endif
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) app_log_write(APP_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) do { } while (0)
+#endif
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) app_log_write(APP_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) do { } while (0)
+#endif
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_VERBOSE
+#define LOG_V(fmt, ...) app_log_write(APP_LOG_LEVEL_VERBOSE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_V(fmt, ...) do { } while (0)
+#endif
+
+#endif // APP_LOG_H
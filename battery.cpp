@@ -0,0 +1,211 @@
+/*
+ * Battery voltage and state of charge.
+ *
+ * Each sample is a burst of BATTERY_OVERSAMPLE oneshot conversions; the
+ * extremes are dropped and the rest averaged before calibration, which takes
+ * the ADC's own noise out and averages across short radio TX bursts.
+ * The sag from the average radio load (I x R of the cell and wiring) is added
+ * back, and an exponential filter plus a hysteresis band on the percentage
+ * keep the indicator from flickering between two values.
+ */
+
+#include <Arduino.h>
+#include <esp_adc/adc_oneshot.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include "battery.h"
+#include "app_events.h"
+#include "app_log.h"
+#include "ble_client.h"
+#include "home_assistant.h"
+#include "task_config.h"
+
+#define BATTERY_ADC_PIN 1              // GPIO1 for battery voltage divider
+#define BATTERY_DIVIDER 2              // 100k+100k divider, so Vbat = V_adc * 2
+#define BATTERY_ADC_ATTEN ADC_ATTEN_DB_12
+#define BATTERY_OVERSAMPLE 64          // Conversions per sample (~1 ms burst)
+#define BATTERY_PERIOD_MS 5000
+#define BATTERY_FILTER_SHIFT 2         // EMA weight 1/4 per sample, ~20 s time constant
+#define BATTERY_HYSTERESIS_PERMILLE 7  // The shown % moves once the SoC is 0.7 % away from it
+
+// Radio load compensation. Tune per board: measure Vbat with the radios idle and busy.
+#define BATTERY_INTERNAL_MOHM 200      // Cell, protection FETs and wiring
+#define BATTERY_LOAD_BLE_MA 15         // Average extra draw with the BLE link up
+#define BATTERY_LOAD_WIFI_MA 60        // Average extra draw with Wi-Fi up (modem sleep)
+
+// Resting Li-ion discharge curve (single cell, ~0.2C), millivolts -> percent
+static const struct {
+    uint16_t mv;
+    uint8_t pct;
+} SOC_CURVE[] = {
+    {3270, 0},  {3610, 5},  {3690, 10}, {3710, 15}, {3730, 20}, {3750, 25},
+    {3770, 30}, {3790, 35}, {3800, 40}, {3820, 45}, {3840, 50}, {3850, 55},
+    {3870, 60}, {3910, 65}, {3950, 70}, {3980, 75}, {4020, 80}, {4080, 85},
+    {4110, 90}, {4150, 95}, {4200, 100},
+};
+#define SOC_CURVE_POINTS (sizeof(SOC_CURVE) / sizeof(SOC_CURVE[0]))
+
+static adc_oneshot_unit_handle_t adc_handle = NULL;
+static adc_cali_handle_t cali_handle = NULL;
+static adc_channel_t adc_channel;
+
+static portMUX_TYPE battery_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t raw_mv = 0;       // Last burst, uncompensated
+static uint32_t comp_mv = 0;      // Last burst, load-compensated
+static uint32_t filtered_mv = 0;  // Exponential filter output
+static uint8_t shown_percent = 0; // Last value sent to the UI
+static bool have_sample = false;
+
+static bool create_calibration(adc_unit_t unit) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cfg = {};
+    cfg.unit_id = unit;
+    cfg.chan = adc_channel;
+    cfg.atten = BATTERY_ADC_ATTEN;
+    cfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+    return adc_cali_create_scheme_curve_fitting(&cfg, &cali_handle) == ESP_OK;
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cfg = {};
+    cfg.unit_id = unit;
+    cfg.atten = BATTERY_ADC_ATTEN;
+    cfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+    return adc_cali_create_scheme_line_fitting(&cfg, &cali_handle) == ESP_OK;
+#else
+    return false;
+#endif
+}
+
+// One oversampled reading at the ADC pin, in mV (0 on failure)
+static uint32_t read_adc_mv() {
+    int raw, lo = INT32_MAX, hi = 0;
+    int32_t sum = 0;
+    int n = 0;
+    for (int i = 0; i < BATTERY_OVERSAMPLE; i++) {
+        if (adc_oneshot_read(adc_handle, adc_channel, &raw) != ESP_OK) continue;
+        sum += raw;
+        n++;
+        if (raw < lo) lo = raw;
+        if (raw > hi) hi = raw;
+    }
+    if (n < 3) return 0;
+    int avg = (sum - lo - hi + (n - 2) / 2) / (n - 2); // Trimmed mean
+
+    int mv;
+    if (cali_handle && adc_cali_raw_to_voltage(cali_handle, avg, &mv) == ESP_OK) {
+        return (uint32_t)mv;
+    }
+    return (uint32_t)avg * 3100 / 4095; // Nominal full scale at 12 dB, uncalibrated
+}
+
+// Voltage the cell would show without the radios' average draw
+static uint32_t radio_load_mv() {
+    uint32_t load_ma = 0;
+    if (ble_is_connected()) load_ma += BATTERY_LOAD_BLE_MA;
+    if (ha_get_net_status() != NET_STATUS_OFFLINE) load_ma += BATTERY_LOAD_WIFI_MA;
+    return load_ma * BATTERY_INTERNAL_MOHM / 1000;
+}
+
+// State of charge in 0.1 % steps, linearly interpolated along SOC_CURVE
+static uint32_t soc_permille(uint32_t mv) {
+    if (mv <= SOC_CURVE[0].mv) return 0;
+    for (size_t i = 1; i < SOC_CURVE_POINTS; i++) {
+        if (mv < SOC_CURVE[i].mv) {
+            uint32_t span_mv = SOC_CURVE[i].mv - SOC_CURVE[i - 1].mv;
+            uint32_t span_pm = (SOC_CURVE[i].pct - SOC_CURVE[i - 1].pct) * 10;
+            return SOC_CURVE[i - 1].pct * 10 + (mv - SOC_CURVE[i - 1].mv) * span_pm / span_mv;
+        }
+    }
+    return 1000;
+}
+
+static void battery_sample() {
+    uint32_t adc_mv = read_adc_mv();
+    if (adc_mv == 0) return;
+    uint32_t vbat = adc_mv * BATTERY_DIVIDER;
+    uint32_t vcomp = vbat + radio_load_mv();
+
+    uint32_t filtered = have_sample ? filtered_mv + (((int32_t)vcomp - (int32_t)filtered_mv) >> BATTERY_FILTER_SHIFT)
+                                    : vcomp; // Seed the filter with the first reading
+    uint32_t soc = soc_permille(filtered);
+    uint8_t percent = shown_percent;
+    if (!have_sample || soc + BATTERY_HYSTERESIS_PERMILLE < (uint32_t)shown_percent * 10 ||
+        soc > (uint32_t)shown_percent * 10 + BATTERY_HYSTERESIS_PERMILLE) {
+        percent = (uint8_t)((soc + 5) / 10);
+    }
+    bool changed = !have_sample || percent != shown_percent;
+
+    portENTER_CRITICAL(&battery_mux);
+    raw_mv = vbat;
+    comp_mv = vcomp;
+    filtered_mv = filtered;
+    shown_percent = percent;
+    have_sample = true;
+    portEXIT_CRITICAL(&battery_mux);
+
+    if (changed) {
+        app_events_post_int(APP_EVT_BATTERY, percent);
+    }
+}
+
+static void battery_task(void* arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        battery_sample();
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(BATTERY_PERIOD_MS));
+    }
+}
+
+void battery_init() {
+    adc_unit_t unit;
+    if (adc_oneshot_io_to_channel(BATTERY_ADC_PIN, &unit, &adc_channel) != ESP_OK) {
+        LOG_E("Battery pin %d is not an ADC pin.", BATTERY_ADC_PIN);
+        return;
+    }
+    adc_oneshot_unit_init_cfg_t unit_cfg = {};
+    unit_cfg.unit_id = unit;
+    unit_cfg.ulp_mode = ADC_ULP_MODE_DISABLE;
+    if (adc_oneshot_new_unit(&unit_cfg, &adc_handle) != ESP_OK) {
+        LOG_E("Failed to claim ADC unit %d for the battery.", (int)unit + 1);
+        adc_handle = NULL;
+        return;
+    }
+    adc_oneshot_chan_cfg_t chan_cfg = {};
+    chan_cfg.atten = BATTERY_ADC_ATTEN;
+    chan_cfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+    adc_oneshot_config_channel(adc_handle, adc_channel, &chan_cfg);
+
+    if (!create_calibration(unit)) {
+        cali_handle = NULL;
+        LOG_W("No ADC eFuse calibration, battery voltage is approximate.");
+    }
+
+    battery_sample(); // First value before the UI's first frame is done
+    if (xTaskCreatePinnedToCore(battery_task, "Battery", BATTERY_TASK_STACK, NULL,
+                                BATTERY_TASK_PRIORITY, NULL, BATTERY_TASK_CORE) != pdPASS) {
+        LOG_E("!!! Failed to create battery task !!!");
+    }
+}
+
+uint32_t battery_get_mv() {
+    portENTER_CRITICAL(&battery_mux);
+    uint32_t mv = filtered_mv;
+    portEXIT_CRITICAL(&battery_mux);
+    return mv;
+}
+
+uint8_t battery_get_percent() {
+    portENTER_CRITICAL(&battery_mux);
+    uint8_t pct = shown_percent;
+    portEXIT_CRITICAL(&battery_mux);
+    return pct;
+}
+
+void battery_dump() {
+    portENTER_CRITICAL(&battery_mux);
+    uint32_t raw = raw_mv, comp = comp_mv, filtered = filtered_mv;
+    uint8_t pct = shown_percent;
+    portEXIT_CRITICAL(&battery_mux);
+    Serial.printf("[%lu] Battery: %lu mV measured, %lu mV load-compensated (+%lu), %lu mV filtered, %u%% (%s)\n",
+                  millis(), (unsigned long)raw, (unsigned long)comp, (unsigned long)(comp - raw),
+                  (unsigned long)filtered, pct, cali_handle ? "calibrated" : "uncalibrated");
+}
@@ -0,0 +1,27 @@
+/*
+ * Battery voltage and state of charge.
+ *
+ * A low-priority task samples the battery divider with the ESP-IDF oneshot
+ * ADC driver (eFuse calibrated, oversampled in bursts), compensates the
+ * voltage sag caused by the radios, smooths it and maps it to a state of
+ * charge through a Li-ion discharge curve. The UI only ever receives the
+ * finished percentage, as an APP_EVT_BATTERY event.
+ */
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <cstdint>
+
+// Sets up the ADC and starts the sampling task
+void battery_init();
+
+// Latest filtered, load-compensated battery voltage in mV (0 until the first sample)
+uint32_t battery_get_mv();
+
+// Latest state of charge, 0..100
+uint8_t battery_get_percent();
+
+// Logs raw, compensated and filtered voltage and the state of charge
+void battery_dump();
+
+#endif // BATTERY_H
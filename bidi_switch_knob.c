@@ -6,20 +6,43 @@
  *
  *
  * Modified by planevina 2025-01-20
+ *
+ * Two decoding backends. PCNT: each pin drives its own pulse counter unit
+ * (glitch filtered, counting both edges) with a watch point at 1. The
+ * watch-point ISR wakes a knob task, which polls the pins only until the pulse
+ * has settled and then reports one detent per complete pulse. Poll: an
+ * esp_timer samples and debounces both pins; it only runs for knobs that use
+ * KNOB_BACKEND_POLL. The knob task's core, priority and stack come from
+ * task_config.h.
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "driver/gpio.h"
 #include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "bidi_switch_knob.h"
+#include "task_config.h"
+
+#if SOC_PCNT_SUPPORTED
+#include "driver/pulse_cnt.h"
+#define KNOB_PCNT_AVAILABLE 1
+#else
+#define KNOB_PCNT_AVAILABLE 0
+#endif
 
 static const char *TAG = "Knob";
 
 #define TICKS_INTERVAL 3
 #define DEBOUNCE_TICKS 2
 
+#define KNOB_PCNT_GLITCH_NS 10000   /*!< Hardware glitch filter (max ~12.7 us at 80 MHz APB) */
+#define KNOB_PCNT_SETTLE_MS 3       /*!< Pin sampling interval while a pulse is in progress */
+
 #define KNOB_CHECK(a, str, ret_val)                               \
     if (!(a))                                                     \
     {                                                             \
@@ -53,6 +76,13 @@ typedef struct Knob
     void *encoder_b;                                /*!< Encoder B phase gpio number */
     void *usr_data[KNOB_EVENT_MAX];                 /*!< User data for event */
     knob_cb_t cb[KNOB_EVENT_MAX];                   /*!< Event callback */
+    knob_backend_t backend;                         /*!< Active decoding backend */
+#if KNOB_PCNT_AVAILABLE
+    pcnt_unit_handle_t pcnt_unit[2];                /*!< Pulse counters for pin A (right) and pin B (left) */
+    pcnt_channel_handle_t pcnt_chan[2];             /*!< One edge channel per unit */
+    int edge_acc[2];                                /*!< Edges not yet reported (an odd one waits for its pair) */
+    TaskHandle_t pcnt_task;                         /*!< Task woken by the watch-point ISR */
+#endif
     struct Knob *next;                              /*!< Next pointer */
 } knob_dev_t;
 
@@ -107,9 +137,156 @@ static void knob_cb(void *args)
     knob_dev_t *target;
     for (target = s_head_handle; target; target = target->next)
     {
-        knob_handler(target);
+        if (target->backend == KNOB_BACKEND_POLL)
+        {
+            knob_handler(target);
+        }
+    }
+}
+
+#if KNOB_PCNT_AVAILABLE
+// Watch-point ISR: the count just reached 1 on one of the pins
+static bool IRAM_ATTR knob_pcnt_watch_cb(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *user_ctx)
+{
+    knob_dev_t *knob = (knob_dev_t *)user_ctx;
+    BaseType_t high_task_awoken = pdFALSE;
+    vTaskNotifyGiveFromISR(knob->pcnt_task, &high_task_awoken);
+    return high_task_awoken == pdTRUE;
+}
+
+// Collects edges from one unit; reports one detent per full pulse once the pin is idle high.
+// Returns true while the pin is still low (pulse in progress).
+static bool knob_pcnt_service_pin(knob_dev_t *knob, int idx, void *gpio, knob_event_t event, bool is_increment)
+{
+    int count = 0;
+    pcnt_unit_get_count(knob->pcnt_unit[idx], &count);
+    if (count)
+    {
+        pcnt_unit_clear_count(knob->pcnt_unit[idx]);
+        knob->edge_acc[idx] += count;
+    }
+
+    if (knob->hal_knob_level(gpio) == 0)
+    {
+        return true;
+    }
+
+    // Idle high: every two edges are one complete pulse. A fast turn can fit several
+    // pulses into one settle interval, so report each; an odd edge waits for its pair.
+    int detents = knob->edge_acc[idx] / 2;
+    knob->edge_acc[idx] %= 2;
+    for (int i = 0; i < detents; i++)
+    {
+        knob->count_value += is_increment ? 1 : -1;
+        knob->event = event;
+        CALL_EVENT_CB(event);
+    }
+    return false;
+}
+
+static void knob_pcnt_task(void *arg)
+{
+    knob_dev_t *knob = (knob_dev_t *)arg;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Sleep until a pin moves
+
+        bool busy;
+        do
+        {
+            vTaskDelay(pdMS_TO_TICKS(KNOB_PCNT_SETTLE_MS)); // Let the contact settle before sampling
+            busy = knob_pcnt_service_pin(knob, 0, knob->encoder_a, KNOB_RIGHT, true);
+            busy |= knob_pcnt_service_pin(knob, 1, knob->encoder_b, KNOB_LEFT, false);
+        } while (busy);
+    }
+}
+
+static void knob_pcnt_deinit(knob_dev_t *knob)
+{
+    if (knob->pcnt_task)
+    {
+        vTaskDelete(knob->pcnt_task);
+        knob->pcnt_task = NULL;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        if (knob->pcnt_unit[i])
+        {
+            pcnt_unit_stop(knob->pcnt_unit[i]);
+            pcnt_unit_disable(knob->pcnt_unit[i]);
+            if (knob->pcnt_chan[i])
+            {
+                pcnt_del_channel(knob->pcnt_chan[i]);
+                knob->pcnt_chan[i] = NULL;
+            }
+            pcnt_del_unit(knob->pcnt_unit[i]);
+            knob->pcnt_unit[i] = NULL;
+        }
+    }
+}
+
+static esp_err_t knob_pcnt_init(knob_dev_t *knob, const knob_config_t *config)
+{
+    const int gpios[2] = {config->gpio_encoder_a, config->gpio_encoder_b};
+    esp_err_t ret = ESP_OK;
+
+    if (xTaskCreatePinnedToCore(knob_pcnt_task, "knob_pcnt", KNOB_TASK_STACK, knob, KNOB_TASK_PRIORITY, &knob->pcnt_task, KNOB_TASK_CORE) != pdPASS)
+    {
+        knob->pcnt_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        pcnt_unit_config_t unit_config = {
+            .low_limit = -100,
+            .high_limit = 100,
+        };
+        ret = pcnt_new_unit(&unit_config, &knob->pcnt_unit[i]);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt unit create failed", _pcnt_fail);
+
+        pcnt_glitch_filter_config_t filter_config = {
+            .max_glitch_ns = KNOB_PCNT_GLITCH_NS,
+        };
+        ret = pcnt_unit_set_glitch_filter(knob->pcnt_unit[i], &filter_config);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt glitch filter failed", _pcnt_fail);
+
+        pcnt_chan_config_t chan_config = {
+            .edge_gpio_num = gpios[i],
+            .level_gpio_num = -1,
+        };
+        ret = pcnt_new_channel(knob->pcnt_unit[i], &chan_config, &knob->pcnt_chan[i]);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt channel create failed", _pcnt_fail);
+
+        // Count every edge; a complete pulse is two edges, bounces add pairs
+        pcnt_channel_set_edge_action(knob->pcnt_chan[i], PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+
+        ret = pcnt_unit_add_watch_point(knob->pcnt_unit[i], 1);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt watch point failed", _pcnt_fail);
+
+        pcnt_event_callbacks_t cbs = {
+            .on_reach = knob_pcnt_watch_cb,
+        };
+        ret = pcnt_unit_register_event_callbacks(knob->pcnt_unit[i], &cbs, knob);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt callback register failed", _pcnt_fail);
+
+        ret = pcnt_unit_enable(knob->pcnt_unit[i]);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt enable failed", _pcnt_fail);
+        pcnt_unit_clear_count(knob->pcnt_unit[i]);
+        ret = pcnt_unit_start(knob->pcnt_unit[i]);
+        KNOB_CHECK_GOTO(ESP_OK == ret, "pcnt start failed", _pcnt_fail);
     }
+
+    // The PCNT driver reconfigures the pins as inputs; keep the pull-ups the knob needs
+    gpio_pullup_en(config->gpio_encoder_a);
+    gpio_pullup_en(config->gpio_encoder_b);
+    return ESP_OK;
+
+_pcnt_fail:
+    knob_pcnt_deinit(knob);
+    return ret;
 }
+#endif
 
 knob_handle_t iot_knob_create(const knob_config_t *config)
 {
@@ -133,10 +310,36 @@ knob_handle_t iot_knob_create(const knob_config_t *config)
     knob->encoder_b_level = knob->hal_knob_level(knob->encoder_b);
 
     knob->event = KNOB_NONE;
+    knob->backend = KNOB_BACKEND_POLL;
+
+#if KNOB_PCNT_AVAILABLE
+    if (config->backend == KNOB_BACKEND_PCNT)
+    {
+        if (knob_pcnt_init(knob, config) == ESP_OK)
+        {
+            knob->backend = KNOB_BACKEND_PCNT;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "PCNT backend unavailable, falling back to polling");
+        }
+    }
+#else
+    if (config->backend == KNOB_BACKEND_PCNT)
+    {
+        ESP_LOGW(TAG, "PCNT not supported on this chip, falling back to polling");
+    }
+#endif
 
     knob->next = s_head_handle;
     s_head_handle = knob;
 
+    if (knob->backend == KNOB_BACKEND_PCNT)
+    {
+        ESP_LOGI(TAG, "Iot Knob Config Succeed (PCNT), encoder A:%d, encoder B:%d", config->gpio_encoder_a, config->gpio_encoder_b);
+        return (knob_handle_t)knob;
+    }
+
     if (!s_knob_timer_handle)
     {
         esp_timer_create_args_t knob_timer = {0};
@@ -153,7 +356,7 @@ knob_handle_t iot_knob_create(const knob_config_t *config)
         s_is_timer_running = true;
     }
 
-    ESP_LOGI(TAG, "Iot Knob Config Succeed, encoder A:%d, encoder B:%d", config->gpio_encoder_a, config->gpio_encoder_b);
+    ESP_LOGI(TAG, "Iot Knob Config Succeed (poll), encoder A:%d, encoder B:%d", config->gpio_encoder_a, config->gpio_encoder_b);
     return (knob_handle_t)knob;
 
 _encoder_deinit:
@@ -167,6 +370,12 @@ esp_err_t iot_knob_delete(knob_handle_t knob_handle)
     esp_err_t ret = ESP_OK;
     KNOB_CHECK(NULL != knob_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
     knob_dev_t *knob = (knob_dev_t *)knob_handle;
+#if KNOB_PCNT_AVAILABLE
+    if (knob->backend == KNOB_BACKEND_PCNT)
+    {
+        knob_pcnt_deinit(knob);
+    }
+#endif
     ret = knob_gpio_deinit((int)(knob->usr_data));
     KNOB_CHECK(ESP_OK == ret, "knob deinit failed", ESP_FAIL);
     knob_dev_t **curr;
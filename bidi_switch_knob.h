@@ -5,6 +5,9 @@
  * 
  * 
  * Modified by planevina 2025-01-20
+ *
+ * The decoding backend (PCNT pulse counter or esp_timer poll) is selected
+ * via knob_config_t.backend.
  */
 
 #pragma once
@@ -32,6 +35,16 @@ extern "C"
         KNOB_NONE,      /*!< EVENT: No event */
     } knob_event_t;
 
+    /**
+     * @brief Knob decoding backend
+     *
+     */
+    typedef enum
+    {
+        KNOB_BACKEND_POLL = 0, /*!< Sample both pins from a periodic esp_timer (default) */
+        KNOB_BACKEND_PCNT,     /*!< Hardware pulse counter; the CPU only wakes when the knob moves */
+    } knob_backend_t;
+
     /**
      * @brief Knob config
      *
@@ -40,6 +53,7 @@ extern "C"
     {
         uint8_t gpio_encoder_a; /*!< Encoder Pin A */
         uint8_t gpio_encoder_b; /*!< Encoder Pin B */
+        knob_backend_t backend; /*!< Decoding backend, falls back to polling if PCNT is unavailable */
     } knob_config_t;
 
     /**
@@ -1,40 +1,134 @@
 /*
  * Bluetooth LE client implementation for the shotStopper controller.
  *
- * Implements a "scan-on-demand" and "connect-on-demand" strategy.
- * An initial read is performed in a separate task on boot which loops
- * until successful, releasing its mutex on each loop to allow
- * write tasks (from encoder/presets) to interrupt.
+ * All link operations run on one long-lived BLE worker task, pinned to the
+ * radio core next to Bluedroid (task_config.h) and fed by a single-slot
+ * command queue. Writes overwrite the slot, so the last value the user picked
+ * always wins and is never dropped. The boot read is retried by the same
+ * worker until it succeeds.
  *
- * connectToServer is now fully synchronous and iterates scan results
- * to avoid race conditions.
- * Corrected BLEScanResults pointer and 'final_success' typo.
+ * Two session modes: on-demand (the default) connects for each operation and
+ * drops the link afterwards; keep-alive holds the link between writes and
+ * reconnects in the background with exponential backoff, so a write is a
+ * single GATT round trip.
+ *
+ * The last good peer address and the characteristic's value and CCCD handles
+ * are cached in NVS (settings.h). A reconnect tries a short direct connect to
+ * that address and binds straight to the cached handles over raw GATTC;
+ * the 5-second scan and service discovery only run when the cache is missing
+ * or turns out stale. connectToServer() is synchronous.
+ *
+ * Notifications from the stopper update target_weight and post the display
+ * and checkmark update, so changes made on the stopper itself show up here.
+ * Write verification waits for the matching notification (with a read-back
+ * fallback for peers that don't echo client writes).
+ *
+ * Discrete intents (a preset tap) skip the knob debounce and queue their write
+ * straight away; the touch-down before it queues BLE_CMD_CONNECT, so the link
+ * is coming up (and held in on-demand mode) by the time the write arrives.
+ *
+ * Every link operation is timed into ble_stats histograms, with failure and
+ * retry counters and the link RSSI. Verified writes and stopper-side changes
+ * are recorded for the shot history. UI changes are posted to the event bus
+ * (app_events.h); this file never touches LVGL objects.
  */
 
 #include <Arduino.h>
-#include <lvgl.h> // Include LVGL FIRST
 #include "ble_client.h"
-#include "lvgl_display.h" // Include AFTER lvgl.h
+#include "encoder.h" // For ble_write_timer (user mid-edit check)
 #include "app_events.h" // Include status definitions
+#include "task_config.h"
+#include "app_log.h"
+#include "settings.h"
+#include "shot_session.h"
+#include "boot_trace.h"
+#include "ble_stats.h"
 #include <BLEDevice.h>
 #include <BLEUtils.h>
 #include <BLEScan.h>
+#include <esp_gattc_api.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
+#include <freertos/queue.h>
 
 // BLE UUIDs
 static BLEUUID serviceUUID("00000000-0000-0000-0000-000000000ffe");
 static BLEUUID charUUID("00000000-0000-0000-0000-00000000ff11");
 
+// Keep-alive reconnect backoff (doubles after each failed attempt)
+#define BLE_RECONNECT_BACKOFF_MIN_MS 1000
+#define BLE_RECONNECT_BACKOFF_MAX_MS 30000
+
+// After BLE_CMD_CONNECT, on-demand mode keeps the link this long for the write that follows
+#define BLE_PREPARE_HOLD_MS 3000
+
+// Direct connect to the cached peer address (skips the scan)
+#define BLE_DIRECT_CONNECT_TIMEOUT_MS 1500
+
+// Raw GATTC operations (cached-handle path)
+#define GATT_OP_TIMEOUT_MS 2000
+#define GATT_PROP_READ   0x01
+#define GATT_PROP_WRITE  0x02
+#define GATT_PROP_NOTIFY 0x04
+
+// How long a write waits for the peer to notify the new value before reading it back
+#define BLE_VERIFY_TIMEOUT_MS 1500
+
 // State variables
 static bool connected = false;
 static BLERemoteCharacteristic* pRemoteCharacteristic = nullptr;
 static BLEAdvertisedDevice* myDevice = nullptr; // Device to connect to
 static BLEClient* pClient = nullptr;
-static SemaphoreHandle_t bleMutex = nullptr; // Mutex to protect BLE operations
-static TaskHandle_t writeTaskHandle = NULL;
-static TaskHandle_t initialReadTaskHandle = NULL;
+static TaskHandle_t workerTaskHandle = NULL;
+static volatile ble_session_mode_t session_mode = BLE_SESSION_MODE_DEFAULT;
+
+// Commands accepted by the BLE worker
+typedef enum {
+    BLE_CMD_WRITE,   // Write and verify 'weight'
+    BLE_CMD_CONNECT, // Connect ahead of an expected write (touch-down on a preset)
+    BLE_CMD_WAKE     // Re-evaluate link state (disconnect, mode change, boot read)
+} ble_cmd_type_t;
+
+typedef struct {
+    ble_cmd_type_t type;
+    int8_t weight;
+    int64_t queued_us; // When write_target_weight() queued it, for the end-to-end time
+} ble_cmd_t;
+
+static QueueHandle_t bleCmdQueue = NULL; // Single slot, overwritten so only the latest write survives
+static volatile bool initial_read_pending = false;
+static TickType_t initial_read_due = 0;
+
+// Cached peer address (persisted through settings.h)
+static char peer_addr[18] = ""; // "aa:bb:cc:dd:ee:ff"
+static uint8_t peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+static bool peer_cache_loaded = false;
+
+// Cached GATT handles for the target characteristic, keyed by peer address
+typedef struct {
+    char addr[18];
+    uint16_t value_handle;
+    uint16_t cccd_handle; // 0 if the characteristic has no CCCD
+    uint8_t props;        // GATT_PROP_* flags
+} gatt_handle_cache_t;
+
+static gatt_handle_cache_t gatt_cache = {};
+static bool handles_bound = false; // true = using gatt_cache handles instead of pRemoteCharacteristic
+
+// Completion state for raw GATTC operations (signalled from the BT task)
+static SemaphoreHandle_t gattOpDone = nullptr;
+static volatile uint16_t gatt_pending_handle = 0;
+static volatile esp_gatt_status_t gatt_op_status = ESP_GATT_OK;
+static uint8_t gatt_read_buf[8];
+static volatile uint16_t gatt_read_len = 0;
+
+// Notification-driven verification
+static bool notify_enabled = false;          // CCCD write succeeded on the current link
+static bool peer_echoes_writes = true;       // Learned: does the peer notify after our own writes?
+static volatile int16_t verify_expected = -1; // Weight a write is waiting to see notified, -1 = none
+static SemaphoreHandle_t verifyDone = nullptr;
 
 // Global target weight
 int8_t target_weight = 36; // Default value
@@ -44,8 +138,7 @@ bool connectToServer();
 void disconnectFromServer();
 bool internal_write_weight(int8_t weight);
 int8_t internal_read_weight();
-static void initial_read_task(void* pvParameters); // Task for boot-up read
-static void write_verify_task(void* pvParameters); // Task for writing weight
+static void ble_worker_task(void* pvParameters); // Owns the link and serves bleCmdQueue
 
 
 // --- BLE Callbacks ---
@@ -62,31 +155,315 @@ class MyAdvertisedDeviceCallbacks : public BLEAdvertisedDeviceCallbacks {
 class MyClientCallback : public BLEClientCallbacks {
     void onConnect(BLEClient* pclient) {
         connected = true;
-        update_ble_status(BLE_STATUS_CONNECTED); // Update UI
-        Serial.printf("[%lu] Connected to BLE Server.\n", millis());
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_CONNECTED); // Update UI
+        LOG_I("Connected to BLE Server.");
     }
 
     void onDisconnect(BLEClient* pclient) {
+        ble_stats_count(BLE_CNT_DISCONNECTS);
         connected = false;
         pRemoteCharacteristic = nullptr; // Crucial: Invalidate characteristic pointer
-        update_ble_status(BLE_STATUS_DISCONNECTED); // Update UI
-        Serial.printf("[%lu] Disconnected from BLE Server.\n", millis());
+        handles_bound = false;
+        notify_enabled = false;
+        if (gatt_pending_handle != 0) {
+            gatt_op_status = ESP_GATT_ERROR; // Fail any raw operation in flight
+            xSemaphoreGive(gattOpDone);
+        }
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_DISCONNECTED); // Update UI
+        LOG_I("Disconnected from BLE Server.");
+        // Wake the worker so keep-alive mode starts reconnecting
+        if (bleCmdQueue != NULL) {
+            ble_cmd_t cmd = {BLE_CMD_WAKE, 0};
+            xQueueSend(bleCmdQueue, &cmd, 0); // Never displaces a pending write
+        }
     }
 };
 
-// --- Core BLE Functions (Connect, Disconnect, Read, Write) ---
+// --- Peer Address Cache ---
+
+// Load the cached peer address from the settings shadow (once)
+static void load_peer_cache() {
+    if (peer_cache_loaded) return;
+    peer_cache_loaded = true;
+    char addr[sizeof(peer_addr)];
+    if (settings_get_str(SETTING_PEER_ADDR, addr, sizeof(addr)) && strlen(addr) == sizeof(peer_addr) - 1) {
+        memcpy(peer_addr, addr, sizeof(peer_addr));
+        peer_addr_type = settings_get_u8(SETTING_PEER_TYPE, BLE_ADDR_TYPE_PUBLIC);
+        LOG_I("Cached peer: %s (type %d)", peer_addr, peer_addr_type);
+    }
+    if (settings_get_blob(SETTING_GATT_CACHE, &gatt_cache, sizeof(gatt_cache)) != sizeof(gatt_cache)) {
+        memset(&gatt_cache, 0, sizeof(gatt_cache));
+    }
+}
 
-// Function to scan FOR and connect TO the BLE server
-bool connectToServer() {
-    if (connected) {
-        Serial.printf("[%lu] Already connected.\n", millis());
+// Remember the peer we just connected to. Only touches flash when it changed.
+static void save_peer_cache(const char* addr, uint8_t type) {
+    if (strcmp(peer_addr, addr) == 0 && peer_addr_type == type) return;
+    strncpy(peer_addr, addr, sizeof(peer_addr) - 1);
+    peer_addr[sizeof(peer_addr) - 1] = '\0';
+    peer_addr_type = type;
+    settings_set_str(SETTING_PEER_ADDR, peer_addr);
+    settings_set_u8(SETTING_PEER_TYPE, peer_addr_type);
+    LOG_I("Saved peer %s (type %d).", peer_addr, peer_addr_type);
+}
+
+// Forget the cached peer (e.g. the device at that address is not our stopper)
+static void clear_peer_cache() {
+    if (peer_addr[0] == '\0') return;
+    peer_addr[0] = '\0';
+    settings_erase(SETTING_PEER_ADDR);
+    settings_erase(SETTING_PEER_TYPE);
+    LOG_I("Cleared cached peer address.");
+}
+
+// --- GATT Handle Cache ---
+
+static bool gatt_cache_matches(const char* addr) {
+    return gatt_cache.value_handle != 0 && strcasecmp(gatt_cache.addr, addr) == 0;
+}
+
+static void save_gatt_cache(const gatt_handle_cache_t* entry) {
+    if (memcmp(&gatt_cache, entry, sizeof(gatt_cache)) == 0 && settings_is_set(SETTING_GATT_CACHE)) return;
+    gatt_cache = *entry;
+    settings_set_blob(SETTING_GATT_CACHE, &gatt_cache, sizeof(gatt_cache));
+    LOG_I("Saved GATT handles for %s.", gatt_cache.addr);
+}
+
+static void invalidate_gatt_cache() {
+    memset(&gatt_cache, 0, sizeof(gatt_cache));
+    handles_bound = false;
+    settings_erase(SETTING_GATT_CACHE);
+    LOG_I("GATT handle cache invalidated.");
+}
+
+// A raw operation failing with one of these means the handles no longer point at our characteristic
+static bool gatt_status_is_stale(esp_gatt_status_t status) {
+    return status == ESP_GATT_INVALID_HANDLE || status == ESP_GATT_NOT_FOUND ||
+           status == ESP_GATT_READ_NOT_PERMIT || status == ESP_GATT_WRITE_NOT_PERMIT ||
+           status == ESP_GATT_REQ_NOT_SUPPORTED || status == ESP_GATT_INVALID_ATTR_LEN;
+}
+
+static bool link_ready() {
+    return connected && (pRemoteCharacteristic != nullptr || handles_bound);
+}
+
+// Called for every notification of the target characteristic (Bluetooth task context)
+static void on_weight_notification(int8_t weight) {
+    LOG_D("Notification: remote target weight = %d", weight);
+
+    if (verify_expected != -1) {
+        // A write is in flight; only its own echo counts
+        if (weight == verify_expected) {
+            verify_expected = -1;
+            xSemaphoreGive(verifyDone);
+        }
+        return;
+    }
+
+    // Don't clobber a value the user is still dialling in; their write will win anyway
+    if (ble_write_timer != NULL && xTimerIsTimerActive(ble_write_timer)) return;
+
+    // Change made on the stopper itself (or a late echo): adopt it
+    target_weight = weight;
+    shot_session_record(SHOT_EVT_NOTIFIED, weight);
+    app_events_post_int(APP_EVT_WEIGHT_CONFIRMED, target_weight);
+}
+
+// Catches notifications and completions of our raw GATTC operations. Runs in the
+// Bluetooth task alongside the library's own handler, so it filters by connection and handle.
+static void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t* param) {
+    if (pClient == nullptr) return;
+
+    if (event == ESP_GATTC_NOTIFY_EVT) {
+        if (param->notify.conn_id == pClient->getConnId() && gatt_cache.value_handle != 0 &&
+            param->notify.handle == gatt_cache.value_handle && param->notify.value_len > 0) {
+            on_weight_notification((int8_t)param->notify.value[0]);
+        }
+        return;
+    }
+
+    if (gatt_pending_handle == 0) return;
+
+    switch (event) {
+        case ESP_GATTC_READ_CHAR_EVT:
+            if (param->read.conn_id != pClient->getConnId() || param->read.handle != gatt_pending_handle) return;
+            gatt_op_status = param->read.status;
+            gatt_read_len = min<uint16_t>(param->read.value_len, sizeof(gatt_read_buf));
+            if (param->read.status == ESP_GATT_OK) {
+                memcpy(gatt_read_buf, param->read.value, gatt_read_len);
+            }
+            break;
+        case ESP_GATTC_WRITE_CHAR_EVT:
+        case ESP_GATTC_WRITE_DESCR_EVT:
+            if (param->write.conn_id != pClient->getConnId() || param->write.handle != gatt_pending_handle) return;
+            gatt_op_status = param->write.status;
+            break;
+        default:
+            return;
+    }
+    xSemaphoreGive(gattOpDone);
+}
+
+// Issue a raw GATTC request on 'handle' and wait for its completion event
+static esp_gatt_status_t gatt_raw_op(uint16_t handle, bool is_descr, bool is_read, const uint8_t* data, uint16_t len) {
+    xSemaphoreTake(gattOpDone, 0); // Drop any stale completion
+    gatt_pending_handle = handle;
+    gatt_op_status = ESP_GATT_ERROR;
+
+    esp_err_t err;
+    if (is_read) {
+        err = esp_ble_gattc_read_char(pClient->getGattcIf(), pClient->getConnId(), handle, ESP_GATT_AUTH_REQ_NONE);
+    } else if (is_descr) {
+        err = esp_ble_gattc_write_char_descr(pClient->getGattcIf(), pClient->getConnId(), handle, len, (uint8_t*)data,
+                                             ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
+    } else {
+        err = esp_ble_gattc_write_char(pClient->getGattcIf(), pClient->getConnId(), handle, len, (uint8_t*)data,
+                                       ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
+    }
+
+    esp_gatt_status_t status = ESP_GATT_ERROR;
+    if (err == ESP_OK && xSemaphoreTake(gattOpDone, pdMS_TO_TICKS(GATT_OP_TIMEOUT_MS)) == pdTRUE) {
+        status = gatt_op_status;
+    } else {
+        LOG_W("Raw GATT op on 0x%04x failed to complete (err %d).", handle, err);
+    }
+    gatt_pending_handle = 0;
+    return status;
+}
+
+// Full discovery of service, characteristic and CCCD. Records the handles in the cache.
+static bool discover_characteristic() {
+    LOG_I(" - Discovering service and characteristic...");
+    int64_t started_us = esp_timer_get_time();
+    BLERemoteService* pRemoteService = nullptr;
+    try { pRemoteService = pClient->getService(serviceUUID); } catch (...) { }
+
+    if (pRemoteService == nullptr) {
+        LOG_W("Failed to find service UUID.");
+        return false;
+    }
+    LOG_I(" - Found service");
+
+    try { pRemoteCharacteristic = pRemoteService->getCharacteristic(charUUID); } catch (...) { }
+
+    if (pRemoteCharacteristic == nullptr) {
+        LOG_W("Failed to find characteristic UUID.");
+        return false;
+    }
+    LOG_I(" - Found characteristic");
+
+    gatt_handle_cache_t entry = {};
+    strncpy(entry.addr, pClient->getPeerAddress().toString().c_str(), sizeof(entry.addr) - 1);
+    entry.value_handle = pRemoteCharacteristic->getHandle();
+    entry.props = (pRemoteCharacteristic->canRead() ? GATT_PROP_READ : 0) |
+                  (pRemoteCharacteristic->canWrite() ? GATT_PROP_WRITE : 0) |
+                  (pRemoteCharacteristic->canNotify() ? GATT_PROP_NOTIFY : 0);
+    if (pRemoteCharacteristic->canNotify()) {
+        BLERemoteDescriptor* pDesc = nullptr;
+        try { pDesc = pRemoteCharacteristic->getDescriptor(BLEUUID((uint16_t)0x2902)); } catch (...) { }
+        if (pDesc) {
+            entry.cccd_handle = pDesc->getHandle();
+        }
+    }
+    save_gatt_cache(&entry);
+    handles_bound = false; // Discovered objects take precedence until the next reconnect
+    ble_stats_record_since(BLE_OP_DISCOVERY, started_us);
+    return true;
+}
+
+// Cached handles were rejected by the peer: drop them and discover on the live link
+static bool rediscover_characteristic() {
+    LOG_W("Cached GATT handles are stale. Re-discovering.");
+    ble_stats_count(BLE_CNT_REDISCOVERIES);
+    invalidate_gatt_cache();
+    return connected && discover_characteristic();
+}
+
+// Turn on notifications through whichever binding is active
+static void enable_notifications() {
+    if (!(gatt_cache.props & GATT_PROP_NOTIFY)) return;
+    const uint8_t notificationOn[] = {0x1, 0x0};
+
+    if (pRemoteCharacteristic != nullptr) {
+         BLERemoteDescriptor* pDesc = pRemoteCharacteristic->getDescriptor(BLEUUID((uint16_t)0x2902));
+         if (pDesc) {
+            // Register with Bluedroid directly: values arrive in gattc_event_handler on both paths.
+            // registerForNotify(NULL) would unregister and write 0x0000 back to the CCCD.
+            esp_ble_gattc_register_for_notify(pClient->getGattcIf(), *pClient->getPeerAddress().getNative(),
+                                              pRemoteCharacteristic->getHandle());
+            if(pDesc->writeValue((uint8_t*)notificationOn, 2, true)) {
+                 notify_enabled = true;
+                 LOG_I(" - Registered for notifications.");
+            }
+         }
+         return;
+    }
+
+    if (gatt_cache.cccd_handle == 0) return;
+    esp_ble_gattc_register_for_notify(pClient->getGattcIf(), *pClient->getPeerAddress().getNative(), gatt_cache.value_handle);
+    esp_gatt_status_t status = gatt_raw_op(gatt_cache.cccd_handle, true, false, notificationOn, 2);
+    if (status == ESP_GATT_OK) {
+        notify_enabled = true;
+        LOG_I(" - Registered for notifications (cached handles).");
+    } else if (gatt_status_is_stale(status) && rediscover_characteristic()) {
+        enable_notifications();
+    }
+}
+
+// Read the characteristic value into 'out'. Returns the length, or -1 on error.
+static int gatt_read_value(uint8_t* out, uint16_t max_len) {
+    if (pRemoteCharacteristic != nullptr) {
+        String value = ""; // Use Arduino String
+        try {
+             value = pRemoteCharacteristic->readValue();
+        } catch (...) {
+             LOG_W("Exception during readValue().");
+             return -1;
+        }
+        uint16_t len = min<uint16_t>(value.length(), max_len);
+        memcpy(out, value.c_str(), len);
+        return len;
+    }
+
+    esp_gatt_status_t status = gatt_raw_op(gatt_cache.value_handle, false, true, nullptr, 0);
+    if (status == ESP_GATT_OK) {
+        uint16_t len = min<uint16_t>(gatt_read_len, max_len);
+        memcpy(out, gatt_read_buf, len);
+        return len;
+    }
+    if (gatt_status_is_stale(status) && rediscover_characteristic()) {
+        return gatt_read_value(out, max_len); // Retry once via the discovered characteristic
+    }
+    return -1;
+}
+
+// Write 'data' to the characteristic with response. Returns true on success.
+static bool gatt_write_value(const uint8_t* data, uint16_t len) {
+    if (pRemoteCharacteristic != nullptr) {
+        try {
+             return pRemoteCharacteristic->writeValue((uint8_t*)data, len, true); // true for response
+        } catch (...) {
+             LOG_W("Exception during writeValue().");
+             return false;
+        }
+    }
+
+    esp_gatt_status_t status = gatt_raw_op(gatt_cache.value_handle, false, false, data, len);
+    if (status == ESP_GATT_OK) {
         return true;
     }
+    if (gatt_status_is_stale(status) && rediscover_characteristic()) {
+        return gatt_write_value(data, len); // Retry once via the discovered characteristic
+    }
+    return false;
+}
 
-    update_ble_status(BLE_STATUS_CONNECTING); // Update UI to "Connecting"
+// --- Core BLE Functions (Connect, Disconnect, Read, Write) ---
 
+// Scan for the stopper and connect to it. Returns true once the link is up.
+static bool scan_and_connect() {
     // 1. Scan for the device (Synchronous approach)
-    Serial.printf("[%lu] Starting 5-second scan to find device...\n", millis());
+    LOG_I("Starting 5-second scan to find device...");
     BLEScan* pScan = BLEDevice::getScan();
     // We don't set a callback, we'll check the results manually
     pScan->setActiveScan(true);
@@ -95,15 +472,17 @@ bool connectToServer() {
 
     // Start a blocking scan for 5 seconds and get the results
     // Corrected: pScan->start() returns a pointer
+    int64_t scan_started_us = esp_timer_get_time();
     BLEScanResults* results = pScan->start(5, false); // false = not continuous
+    ble_stats_record_since(BLE_OP_SCAN, scan_started_us);
 
     if (results == nullptr) {
-        Serial.printf("[%lu] Scan failed to start.\n", millis());
-        update_ble_status(BLE_STATUS_FAILED); // Red icon
+        LOG_W("Scan failed to start.");
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED); // Red icon
         return false;
     }
 
-    Serial.printf("[%lu] Scan finished. Found %d devices.\n", millis(), results->getCount());
+    LOG_I("Scan finished. Found %d devices.", results->getCount());
     
 
     // Clear the old 'myDevice'
@@ -117,7 +496,7 @@ bool connectToServer() {
     for (int i = 0; i < results->getCount(); i++) { 
         BLEAdvertisedDevice device = results->getDevice(i);
         if (device.isAdvertisingService(serviceUUID)) {
-            Serial.printf("[%lu] Found target device: %s\n", millis(), device.getAddress().toString().c_str());
+            LOG_I("Found target device: %s", device.getAddress().toString().c_str());
             myDevice = new BLEAdvertisedDevice(device); // Store the found device info
             break; // Stop searching
         }
@@ -127,303 +506,396 @@ bool connectToServer() {
 
     // 3. Check if device was found
     if (myDevice == nullptr) {
-        Serial.printf("[%lu] Target device not found in scan results.\n", millis());
-        update_ble_status(BLE_STATUS_FAILED); // Red icon
+        LOG_W("Target device not found in scan results.");
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED); // Red icon
         return false;
     }
     
-    Serial.printf("[%lu] Device found. Attempting connection to %s\n", millis(), myDevice->getAddress().toString().c_str());
+    LOG_I("Device found. Attempting connection to %s", myDevice->getAddress().toString().c_str());
+
+    // 4. Connect (client is created by connectToServer)
+    if (!pClient->connect(myDevice)) {
+        LOG_W(" - Connection failed");
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED); // Update UI
+        return false;
+    }
+    save_peer_cache(myDevice->getAddress().toString().c_str(), myDevice->getAddressType());
+    return true;
+}
+
+// Function to connect TO the BLE server, directly if its address is cached
+bool connectToServer() {
+    if (link_ready()) {
+        LOG_I("Already connected.");
+        return true;
+    }
+
+    app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_CONNECTING); // Update UI to "Connecting"
+    load_peer_cache();
+    ble_stats_count(BLE_CNT_CONNECT_ATTEMPTS);
+    int64_t started_us = esp_timer_get_time(); // Includes the scan when we need one
 
-    // 4. Create Client and Connect
     if (pClient == nullptr) {
          pClient = BLEDevice::createClient();
-         Serial.printf("[%lu]  - Created client\n", millis());
+         LOG_I(" - Created client");
          pClient->setClientCallbacks(new MyClientCallback());
     }
 
-    if (!pClient->connect(myDevice)) {
-        Serial.printf("[%lu]  - Connection failed\n", millis());
-        update_ble_status(BLE_STATUS_FAILED); // Update UI
-        return false;
+    // Try the cached address first, fall back to a full scan
+    bool direct = false;
+    if (peer_addr[0] != '\0') {
+        LOG_I("Direct connect to cached peer %s...", peer_addr);
+        direct = pClient->connect(BLEAddress(peer_addr), peer_addr_type, BLE_DIRECT_CONNECT_TIMEOUT_MS);
+        if (!direct) {
+            LOG_W(" - Direct connect failed, falling back to scan.");
+            ble_stats_count(BLE_CNT_DIRECT_FALLBACKS);
+        }
+    }
+    if (!direct && !scan_and_connect()) {
+        ble_stats_count(BLE_CNT_CONNECT_FAILURES);
+        return false; // scan_and_connect() already set FAILED status
     }
-    Serial.printf("[%lu]  - Connection successful (pending callback)\n", millis());
+    ble_stats_record_since(BLE_OP_CONNECT, started_us);
+    LOG_I(" - Connection successful (pending callback)");
     vTaskDelay(pdMS_TO_TICKS(100)); // Give time for onConnect callback
 
-    // 5. Get Service and Characteristic
-    BLERemoteService* pRemoteService = nullptr;
-    try { pRemoteService = pClient->getService(serviceUUID); } catch (...) { }
-
-    if (pRemoteService == nullptr) {
-        Serial.printf("[%lu] Failed to find service UUID.\n", millis());
+    // 5. Bind to the characteristic: cached handles if we know this peer, otherwise discover
+    String connected_addr = pClient->getPeerAddress().toString();
+    if (gatt_cache_matches(connected_addr.c_str())) {
+        handles_bound = true;
+        LOG_I(" - Bound to cached handles (value 0x%04x, cccd 0x%04x)",
+                      gatt_cache.value_handle, gatt_cache.cccd_handle);
+    } else if (!discover_characteristic()) {
+        if (direct) {
+            clear_peer_cache(); // Something else lives at that address now
+        }
         pClient->disconnect();
-        update_ble_status(BLE_STATUS_FAILED);
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED);
+        ble_stats_count(BLE_CNT_CONNECT_FAILURES);
         return false;
     }
-    Serial.printf("[%lu]  - Found service\n", millis());
 
-    try { pRemoteCharacteristic = pRemoteService->getCharacteristic(charUUID); } catch (...) { }
+    // Register for notifications (optional, but good)
+    enable_notifications();
+    ble_stats_set_rssi((int8_t)pClient->getRssi());
 
-    if (pRemoteCharacteristic == nullptr) {
-        Serial.printf("[%lu] Failed to find characteristic UUID.\n", millis());
-        pClient->disconnect();
-        update_ble_status(BLE_STATUS_FAILED);
+    app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_CONNECTED); // Green icon
+    return true;
+}
+
+// Confirm the peer holds 'weight' after a successful write.
+// Prefers the peer's notification; falls back to a read-back on timeout or if
+// the peer has shown it doesn't echo our own writes.
+static bool verify_written_weight_once(int8_t weight) {
+    if (notify_enabled && peer_echoes_writes) {
+        if (xSemaphoreTake(verifyDone, pdMS_TO_TICKS(BLE_VERIFY_TIMEOUT_MS)) == pdTRUE) {
+            LOG_I("Verified by notification.");
+            return true;
+        }
+        LOG_W("No matching notification within %d ms. Reading back.", BLE_VERIFY_TIMEOUT_MS);
+        ble_stats_count(BLE_CNT_VERIFY_READBACKS);
+        verify_expected = -1;
+        int8_t read_value = internal_read_weight();
+        if (read_value == weight) {
+            peer_echoes_writes = false; // Stop waiting on notifications that never come
+            return true;
+        }
+        LOG_W("Remote value (%d) != written value (%d).", read_value, weight);
         return false;
     }
-    Serial.printf("[%lu]  - Found characteristic\n", millis());
 
-    // Register for notifications (optional, but good)
-    if (pRemoteCharacteristic->canNotify()) {
-         const uint8_t notificationOn[] = {0x1, 0x0};
-         BLERemoteDescriptor* pDesc = pRemoteCharacteristic->getDescriptor(BLEUUID((uint16_t)0x2902));
-         if (pDesc) {
-            if(pDesc->writeValue((uint8_t*)notificationOn, 2, true)) {
-                 pRemoteCharacteristic->registerForNotify(NULL); // Can use NULL if callback is simple
-                 Serial.printf("[%lu]  - Registered for notifications.\n", millis());
-            }
-         }
+    verify_expected = -1;
+    if (xSemaphoreTake(verifyDone, 0) == pdTRUE) {
+        peer_echoes_writes = true; // The echo beat us here; prefer notifications again
+        return true;
     }
+    int8_t read_value = internal_read_weight();
+    if (read_value != weight) {
+        LOG_W("Remote value (%d) != written value (%d).", read_value, weight);
+    }
+    return read_value == weight;
+}
 
-    update_ble_status(BLE_STATUS_CONNECTED); // Green icon
-    return true;
+// Verification wrapper that feeds the verify histogram and failure counter
+static bool verify_written_weight(int8_t weight) {
+    int64_t started_us = esp_timer_get_time();
+    bool verified = verify_written_weight_once(weight);
+    if (verified) {
+        ble_stats_record_since(BLE_OP_VERIFY, started_us);
+    } else {
+        ble_stats_count(BLE_CNT_VERIFY_FAILURES);
+    }
+    return verified;
 }
 
 // Function to disconnect from the BLE server
 void disconnectFromServer() {
     if (pClient != nullptr && pClient->isConnected()) {
-        Serial.printf("[%lu] Disconnecting from server...\n", millis());
+        LOG_I("Disconnecting from server...");
         pClient->disconnect();
     } else {
-         Serial.printf("[%lu] Already disconnected or client doesn't exist.\n", millis());
+         LOG_I("Already disconnected or client doesn't exist.");
     }
     // Callback sets state and UI
     connected = false;
     pRemoteCharacteristic = nullptr;
-    update_ble_status(BLE_STATUS_DISCONNECTED); // Ensure UI is grey
+    handles_bound = false;
+    app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_DISCONNECTED); // Ensure UI is grey
 }
 
 // Function to read the value internally, returns weight or -1 on error
 int8_t internal_read_weight() {
-    if (connected && pRemoteCharacteristic != nullptr && pRemoteCharacteristic->canRead()) {
-        Serial.printf("[%lu] Reading target weight from BLE device...\n", millis());
-        String value = ""; // Use Arduino String
-        try {
-             value = pRemoteCharacteristic->readValue();
-        } catch (...) {
-             Serial.printf("[%lu] Exception during readValue().\n", millis());
-             return -1;
-        }
-
-        if (value.length() > 0) {
-            Serial.printf("[%lu] Read value: %d\n", millis(), (int8_t)value[0]);
+    if (link_ready() && (gatt_cache.props & GATT_PROP_READ)) {
+        LOG_I("Reading target weight from BLE device...");
+        uint8_t value[4];
+        int64_t started_us = esp_timer_get_time();
+        int len = gatt_read_value(value, sizeof(value));
+
+        if (len > 0) {
+            ble_stats_record_since(BLE_OP_READ, started_us);
+            LOG_I("Read value: %d", (int8_t)value[0]);
             return (int8_t)value[0];
         }
-        Serial.printf("[%lu] Read failed: No data.\n", millis());
+        ble_stats_count(BLE_CNT_READ_FAILURES);
+        LOG_W("Read failed: No data.");
         return -1;
     } else {
-        Serial.printf("[%lu] Cannot read: connected=%d, char=%p\n", millis(), connected, pRemoteCharacteristic);
+        LOG_W("Cannot read: connected=%d, char=%p, bound=%d", connected, pRemoteCharacteristic, handles_bound);
         return -1;
     }
 }
 
 // Function to write the value internally, returns true on success
 bool internal_write_weight(int8_t weight) {
-    if (connected && pRemoteCharacteristic != nullptr && pRemoteCharacteristic->canWrite()) {
-        Serial.printf("[%lu] Writing target weight to BLE device: %d\n", millis(), weight);
-        bool writeSuccess = false;
-        try {
-             writeSuccess = pRemoteCharacteristic->writeValue((uint8_t*)&weight, 1, true); // true for response
-        } catch (...) {
-             Serial.printf("[%lu] Exception during writeValue().\n", millis());
-             writeSuccess = false;
-        }
+    if (link_ready() && (gatt_cache.props & GATT_PROP_WRITE)) {
+        LOG_I("Writing target weight to BLE device: %d", weight);
+        int64_t started_us = esp_timer_get_time();
+        bool writeSuccess = gatt_write_value((uint8_t*)&weight, 1);
 
         if(writeSuccess) {
-            Serial.printf("[%lu] Write successful (with response).\n", millis());
+            ble_stats_record_since(BLE_OP_WRITE, started_us);
+            LOG_I("Write successful (with response).");
             return true;
         } else {
-            Serial.printf("[%lu] Write failed (or no response).\n", millis());
+            ble_stats_count(BLE_CNT_WRITE_FAILURES);
+            LOG_W("Write failed (or no response).");
             return false;
         }
     } else {
-         Serial.printf("[%lu] Cannot write: connected=%d, char=%p\n", millis(), connected, pRemoteCharacteristic);
+         LOG_W("Cannot write: connected=%d, char=%p, bound=%d", connected, pRemoteCharacteristic, handles_bound);
         return false;
     }
 }
 
 
-// --- FreeRTOS Tasks ---
-
-// Task for the initial read on boot
-static void initial_read_task(void* pvParameters) {
-    Serial.printf("[%lu] Initial read task started. Waiting 1s before first attempt.\n", millis());
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Wait 1 second before starting
-
-    while(true) { // Loop forever until successful
-        if (xSemaphoreTake(bleMutex, pdMS_TO_TICKS(15000)) == pdTRUE) {
-            Serial.printf("[%lu] Initial read task acquired mutex. Attempting connect...\n", millis());
-            
-            if (connectToServer()) { // This now scans AND connects
-                Serial.printf("[%lu] Initial connect successful. Reading value...\n", millis());
-                int8_t initial_weight = internal_read_weight();
-                
-                disconnectFromServer(); // Disconnect after read
-                
-                if (initial_weight != -1) {
-                    target_weight = initial_weight;
-                    update_display_value(target_weight);
-                    show_verification_checkmark(); // Show checkmark for initial read
-                    update_ble_status(BLE_STATUS_DISCONNECTED); // Set to Grey on success
-                    Serial.printf("[%lu] Initial weight read: %d. Task succeeding.\n", millis(), target_weight);
-                    
-                    xSemaphoreGive(bleMutex); // Release mutex
-                    break; // <<<--- EXIT THE LOOP ON SUCCESS
-                } else {
-                    Serial.printf("[%lu] Initial read failed.\n", millis());
-                    update_ble_status(BLE_STATUS_FAILED); // Red icon
-                }
-            } else {
-                Serial.printf("[%lu] Initial connect failed (device not found or error).\n", millis());
-                // connectToServer() already sets FAILED status
-            }
+// --- BLE Worker ---
 
-            xSemaphoreGive(bleMutex); // CRITICAL: Release mutex *before* delay
-        } else {
-            Serial.printf("[%lu] Initial read task failed to get mutex.\n", millis());
-            update_ble_status(BLE_STATUS_FAILED); // Red icon
-        }
+// Write sequence: connect (no-op while the session is up) -> write -> verify.
+// Returns true once the peer has confirmed the value.
+static bool perform_write(int8_t weight_to_write, int64_t queued_us) {
+    bool was_connected = link_ready();
+    LOG_I("Worker writing weight %d.", weight_to_write);
 
-        Serial.printf("[%lu] Retrying initial read in 5 seconds...\n", millis());
-        vTaskDelay(pdMS_TO_TICKS(5000)); // Wait 5 seconds before retry
+    // 1. Connect (cached address first, scan as fallback)
+    if (!connectToServer()) {
+        LOG_W("Write failed to connect.");
+        app_events_post_int(APP_EVT_WEIGHT_UNVERIFIED, weight_to_write);
+        return false; // connectToServer already sets FAILED status if needed
+    }
+    if (!was_connected) {
+        vTaskDelay(pdMS_TO_TICKS(100)); // Short delay after a fresh connect
     }
 
-    Serial.printf("[%lu] Initial read task finished. Deleting task.\n", millis());
-    initialReadTaskHandle = NULL;
-    vTaskDelete(NULL); // Delete self
-}
+    // 2. Write (arm verification first, the echo can beat the write response)
+    xSemaphoreTake(verifyDone, 0);
+    verify_expected = weight_to_write;
+    if (!internal_write_weight(weight_to_write)) {
+        verify_expected = -1;
+        LOG_W("Write command failed.");
+        app_events_post_int(APP_EVT_WEIGHT_UNVERIFIED, weight_to_write);
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED);
+        return false;
+    }
+    LOG_I("Write command successful. Verifying.");
 
+    // 3. Wait for the peer to confirm the new value
+    if (!verify_written_weight(weight_to_write)) {
+        LOG_W("Verification FAILED for written value (%d).", weight_to_write);
+        app_events_post_int(APP_EVT_WEIGHT_UNVERIFIED, weight_to_write);
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED); // Indicate failure
+        return false;
+    }
 
-// This task handles the connect -> write -> read -> disconnect sequence
-void write_verify_task(void* pvParameters) {
-    int8_t weight_to_write = *(int8_t*)pvParameters;
-    bool final_success = false;
+    LOG_I("Verification successful! Remote value matches written value (%d).", weight_to_write);
+    boot_trace_mark(BOOT_MARK_BLE_SYNC); // First verified weight, if the boot read hasn't got there first
+    ble_stats_record_since(BLE_OP_END_TO_END, queued_us);
+    target_weight = weight_to_write; // Update global state ONLY on success
+    shot_session_record(SHOT_EVT_TARGET_WRITTEN, weight_to_write);
+    app_events_post_int(APP_EVT_WEIGHT_CONFIRMED, target_weight); // Update UI ONLY on success
+    // Grey when the link will be dropped, green while it is kept alive
+    app_events_post_int(APP_EVT_BLE_STATUS, session_mode == BLE_SESSION_ON_DEMAND ? BLE_STATUS_DISCONNECTED : BLE_STATUS_CONNECTED);
+    return true;
+}
 
-    // 1. Acquire Mutex
-    Serial.printf("[%lu] Write task started for weight %d. Waiting for mutex...\n", millis(), weight_to_write);
-    if (xSemaphoreTake(bleMutex, pdMS_TO_TICKS(15000)) == pdTRUE) {
-        Serial.printf("[%lu] Write task acquired mutex.\n", millis());
+// Boot sync: connect and adopt the stopper's current target weight
+static bool perform_initial_read() {
+    LOG_I("Initial read: attempting connect...");
+    if (!connectToServer()) {
+        LOG_W("Initial connect failed (device not found or error).");
+        return false; // connectToServer() already sets FAILED status
+    }
 
-        // 2. Connect (this now includes scanning)
-        if (connectToServer()) {
-            Serial.printf("[%lu] Connection successful. Proceeding to write.\n", millis());
-            vTaskDelay(pdMS_TO_TICKS(100)); // Short delay
+    int8_t initial_weight = internal_read_weight();
+    if (initial_weight == -1) {
+        LOG_W("Initial read failed.");
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED); // Red icon
+        return false;
+    }
 
-            // 3. Write
-            if (internal_write_weight(weight_to_write)) {
-                 Serial.printf("[%lu] Write command successful. Delaying before verify.\n", millis());
-                 vTaskDelay(pdMS_TO_TICKS(200)); // Delay before reading back
+    target_weight = initial_weight;
+    app_events_post_int(APP_EVT_WEIGHT_CONFIRMED, target_weight); // Shows the checkmark for the initial read
+    app_events_post_int(APP_EVT_BLE_STATUS, session_mode == BLE_SESSION_ON_DEMAND ? BLE_STATUS_DISCONNECTED : BLE_STATUS_CONNECTED);
+    LOG_I("Initial weight read: %d.", target_weight);
+    boot_trace_mark(BOOT_MARK_BLE_SYNC);
+    return true;
+}
 
-                // 4. Read back to verify
-                int8_t read_value = internal_read_weight();
-                if (read_value == weight_to_write) {
-                    Serial.printf("[%lu] Verification successful! Remote value (%d) matches written value (%d).\n", millis(), read_value, weight_to_write);
-                    target_weight = weight_to_write; // Update global state ONLY on success
-                    update_display_value(target_weight); // Update UI ONLY on success
-                    show_verification_checkmark();
-                    final_success = true; // Mark overall success
-                } else {
-                    Serial.printf("[%lu] Verification FAILED! Remote value (%d) != written value (%d).\n", millis(), read_value, weight_to_write);
-                    hide_verification_checkmark();
-                    update_ble_status(BLE_STATUS_FAILED); // Indicate failure
+// The single long-lived task that owns the BLE link.
+// It serves the coalescing command queue, retries the boot read, keeps the
+// link alive with exponential backoff, and drops it when idle in on-demand mode.
+static void ble_worker_task(void* pvParameters) {
+    uint32_t backoff_ms = BLE_RECONNECT_BACKOFF_MIN_MS;
+    TickType_t wait = portMAX_DELAY;
+    bool link_hold = false;    // On-demand: keep the link until hold_until (BLE_CMD_CONNECT)
+    TickType_t hold_until = 0;
+    ble_cmd_t cmd;
+
+    while (true) {
+        if (xQueueReceive(bleCmdQueue, &cmd, wait) == pdTRUE) {
+            if (cmd.type == BLE_CMD_WRITE) {
+                if (perform_write(cmd.weight, cmd.queued_us)) {
+                    initial_read_pending = false; // A verified write is as good as a sync
+                }
+                link_hold = false; // The expected write has happened
+            } else if (cmd.type == BLE_CMD_CONNECT) {
+                // The user is about to pick a value: don't make them wait out a backoff.
+                // Keep-alive mode reconnects below; on-demand mode connects here.
+                backoff_ms = BLE_RECONNECT_BACKOFF_MIN_MS;
+                link_hold = true;
+                hold_until = xTaskGetTickCount() + pdMS_TO_TICKS(BLE_PREPARE_HOLD_MS);
+                if (session_mode == BLE_SESSION_ON_DEMAND && !link_ready()) {
+                    LOG_I("Connecting ahead of a write...");
+                    connectToServer();
                 }
+            }
+        }
+
+        wait = portMAX_DELAY;
+        TickType_t now = xTaskGetTickCount();
+        if (initial_read_pending) {
+            if ((int32_t)(initial_read_due - now) > 0) {
+                wait = initial_read_due - now; // Not yet due
+            } else if (perform_initial_read()) {
+                initial_read_pending = false;
+                backoff_ms = BLE_RECONNECT_BACKOFF_MIN_MS;
             } else {
-                 Serial.printf("[%lu] Write command failed.\n", millis());
-                 hide_verification_checkmark();
-                 update_ble_status(BLE_STATUS_FAILED);
+                LOG_I("Retrying initial read in 5 seconds...");
+                ble_stats_count(BLE_CNT_BOOT_READ_RETRIES);
+                initial_read_due = now + pdMS_TO_TICKS(5000);
+                wait = pdMS_TO_TICKS(5000);
             }
+        } else if (session_mode == BLE_SESSION_KEEP_ALIVE && !link_ready()) {
+            LOG_I("Worker reconnecting session...");
+            if (connectToServer()) {
+                LOG_I("Session re-established.");
+                backoff_ms = BLE_RECONNECT_BACKOFF_MIN_MS;
+            } else {
+                LOG_W("Reconnect failed. Retrying in %lu ms.", backoff_ms);
+                ble_stats_count(BLE_CNT_RECONNECT_RETRIES);
+                wait = pdMS_TO_TICKS(backoff_ms); // A new command cuts this short
+                backoff_ms = min<uint32_t>(backoff_ms * 2, BLE_RECONNECT_BACKOFF_MAX_MS);
+            }
+        }
 
-            // 5. Disconnect (regardless of write/verify outcome)
-             Serial.printf("[%lu] Disconnecting after operation...\n", millis());
+        // On-demand: don't hold the link while idle (but keep it for a queued or expected write)
+        now = xTaskGetTickCount();
+        if (link_hold && (int32_t)(hold_until - now) <= 0) link_hold = false;
+        if (session_mode == BLE_SESSION_ON_DEMAND && connected && link_hold) {
+            if (hold_until - now < wait) wait = hold_until - now; // Re-check when the hold ends
+        } else if (session_mode == BLE_SESSION_ON_DEMAND && connected && uxQueueMessagesWaiting(bleCmdQueue) == 0) {
+            LOG_I("Disconnecting after operation...");
             disconnectFromServer();
-             vTaskDelay(pdMS_TO_TICKS(500)); // Give some time for disconnect CB
-
-        } else {
-            Serial.printf("[%lu] Write task failed to connect.\n", millis());
-            hide_verification_checkmark();
-            // connectToServer already sets FAILED status if needed
+            vTaskDelay(pdMS_TO_TICKS(500)); // Give some time for disconnect CB
         }
+    }
+}
 
-        // 6. Release Mutex
-        xSemaphoreGive(bleMutex);
-        Serial.printf("[%lu] Write task released mutex.\n", millis());
+// --- Public Functions (Called by other modules) ---
 
-    } else {
-        Serial.printf("[%lu] Write task failed to acquire mutex. Operation aborted.\n", millis());
-        hide_verification_checkmark();
-        update_ble_status(BLE_STATUS_FAILED); // Indicate failure
-    }
-    
-    // Set icon to Grey if successful, otherwise it will be Red
-    if (final_success) {
-        update_ble_status(BLE_STATUS_DISCONNECTED); // Grey icon
-    }
+// Switch between keep-alive and on-demand link management at runtime
+void ble_set_session_mode(ble_session_mode_t mode) {
+    if (mode == session_mode) return;
+    session_mode = mode;
+    LOG_I("BLE session mode: %s", mode == BLE_SESSION_KEEP_ALIVE ? "keep-alive" : "on-demand");
 
-    Serial.printf("[%lu] Write task finished. Final success: %d. Deleting task.\n", millis(), final_success);
-    writeTaskHandle = NULL; // Mark task as completed *before* deleting
-    vTaskDelete(NULL); // Delete self
+    // Wake the worker so it connects or drops the link for the new mode
+    ble_cmd_t cmd = {BLE_CMD_WAKE, 0};
+    xQueueSend(bleCmdQueue, &cmd, 0); // A pending write wakes it just as well
 }
 
-// --- Public Functions (Called by other modules) ---
+ble_session_mode_t ble_get_session_mode() {
+    return session_mode;
+}
+
+bool ble_is_connected() {
+    return connected;
+}
 
-// Public function to create the initial read task
+// Public function to schedule the boot-up read on the worker
 void ble_perform_initial_read() {
-    if (initialReadTaskHandle != NULL) {
-        Serial.println("Initial read task already running.");
+    if (initial_read_pending) {
+        LOG_I("Initial read already scheduled.");
         return;
     }
-    Serial.println("Creating initial read task...");
-    BaseType_t taskCreated = xTaskCreate(
-        initial_read_task,
-        "InitialReadTask",
-        4096, // Stack size
-        NULL, // No parameters
-        5,    // Priority
-        &initialReadTaskHandle
-    );
-    if (taskCreated != pdPASS) {
-        Serial.println("Failed to create initial read task!");
-        initialReadTaskHandle = NULL;
-        update_ble_status(BLE_STATUS_FAILED);
-    }
+    LOG_I("Scheduling initial read...");
+    initial_read_due = xTaskGetTickCount() + pdMS_TO_TICKS(1000); // Wait 1 second before starting
+    initial_read_pending = true;
+    ble_cmd_t cmd = {BLE_CMD_WAKE, 0};
+    xQueueSend(bleCmdQueue, &cmd, 0);
 }
 
-// Public function to initiate writing the target weight
-void write_target_weight(int8_t weight) {
-     static int8_t weight_buffer; // Static buffer to hold the weight argument
+// Queues a connect unless the link is already up for good. A write already in
+// the slot wins: queueing a connect behind it would add nothing.
+void ble_prepare_write() {
+    if (bleCmdQueue == NULL) return;
+    if (session_mode == BLE_SESSION_KEEP_ALIVE && link_ready()) return;
+    ble_cmd_t cmd = {BLE_CMD_CONNECT, 0, esp_timer_get_time()};
+    xQueueSend(bleCmdQueue, &cmd, 0);
+}
 
-    // Check if another write/read task is already running
-    if (writeTaskHandle != NULL || initialReadTaskHandle != NULL) {
-         Serial.printf("[%lu] BLE operation already in progress. Ignoring new request for %d.\n", millis(), weight);
-         return;
+// Public function to initiate writing the target weight.
+// Never dropped: a write still waiting in the queue is replaced by this newer value.
+// That includes a BLE_CMD_CONNECT from ble_prepare_write() the worker hasn't taken
+// yet (tap faster than the worker wakes): the write connects by itself, so losing
+// the connect costs nothing. Once the worker has taken the connect, the write waits
+// in the slot and is served as soon as connectToServer() returns.
+// Callable from any task (the knob debounce timer, the LVGL task); the checkmark is
+// hidden through the event bus, never directly.
+void write_target_weight(int8_t weight) {
+    if (bleCmdQueue == NULL) {
+        LOG_W("BLE worker not running. Cannot write %d.", weight);
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_FAILED);
+        return;
     }
 
-    weight_buffer = weight; // Store the weight to be passed to the task
-    hide_verification_checkmark(); // Hide checkmark immediately on new write request
-    update_ble_status(BLE_STATUS_CONNECTING); // Set status to Connecting *before* creating task
-
-    Serial.printf("[%lu] Creating write task for weight: %d\n", millis(), weight);
-    BaseType_t taskCreated = xTaskCreate(write_verify_task,
-                                         "BLE_WriteVerify",
-                                         4096, // Stack size
-                                         &weight_buffer, // Pass address of the buffer
-                                         5,    // Priority
-                                         &writeTaskHandle); // Store task handle
-
-    if (taskCreated != pdPASS) {
-        Serial.printf("[%lu] Failed to create write task!\n", millis());
-        writeTaskHandle = NULL; // Ensure handle is null if creation failed
-        update_ble_status(BLE_STATUS_FAILED);
-        hide_verification_checkmark();
+    app_events_post_int(APP_EVT_WEIGHT_UNVERIFIED, weight); // Hide checkmark until this write is confirmed
+    if (!link_ready()) {
+        app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_CONNECTING); // Set status to Connecting before the worker picks it up
     }
+
+    ble_cmd_t cmd = {BLE_CMD_WRITE, weight, esp_timer_get_time()};
+    xQueueOverwrite(bleCmdQueue, &cmd); // Latest value wins
+    LOG_I("Queued write for weight: %d", weight);
 }
 
 
@@ -431,16 +903,22 @@ void write_target_weight(int8_t weight) {
 
 // Initialize the BLE client
 void ble_client_init() {
-    Serial.println("Initializing BLE client...");
-    bleMutex = xSemaphoreCreateMutex(); // Create mutex
-    if (bleMutex == NULL) {
-         Serial.println("!!! Failed to create BLE mutex !!!");
-    }
+    LOG_I("Initializing BLE client...");
+    bleCmdQueue = xQueueCreate(1, sizeof(ble_cmd_t)); // Single slot: pending writes coalesce
+    gattOpDone = xSemaphoreCreateBinary();
+    verifyDone = xSemaphoreCreateBinary();
     BLEDevice::init("");
+    BLEDevice::setCustomGattcHandler(gattc_event_handler); // Completions for cached-handle operations
     // We need to set a callback handler, even if it's an empty one, 
     // for the scan results iteration to work correctly.
     BLEDevice::getScan()->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
-    Serial.println("BLE client initialized. Ready for on-demand connection.");
-    update_ble_status(BLE_STATUS_DISCONNECTED); // Initial status
-}
 
+    if (bleCmdQueue == NULL ||
+        xTaskCreatePinnedToCore(ble_worker_task, "BLE_Worker", BLE_TASK_STACK, NULL, BLE_TASK_PRIORITY,
+                                &workerTaskHandle, BLE_TASK_CORE) != pdPASS) {
+        LOG_E("!!! Failed to create BLE worker !!!");
+        workerTaskHandle = NULL;
+    }
+    LOG_I("BLE client initialized. Session mode: %s", session_mode == BLE_SESSION_KEEP_ALIVE ? "keep-alive" : "on-demand");
+    app_events_post_int(APP_EVT_BLE_STATUS, BLE_STATUS_DISCONNECTED); // Initial status
+}
@@ -1,18 +1,36 @@
 /*
  * Header for the BLE client module.
  *
- * Declares the functions for initializing the BLE client and interacting
- * with the target weight characteristic.
- * Added ble_perform_initial_read for boot-up sequence.
+ * Declares the functions for initializing the BLE client, the boot-up read
+ * and writing the target weight characteristic, and selects the session
+ * mode: on-demand (low power, default) or keep-alive (persistent link).
  */
 #ifndef BLE_CLIENT_H
 #define BLE_CLIENT_H
 
 #include <cstdint>
 
+// Link management strategy for the shotStopper connection
+typedef enum {
+    BLE_SESSION_ON_DEMAND,  // Scan, connect, operate, disconnect (lowest power)
+    BLE_SESSION_KEEP_ALIVE  // Stay connected, reconnect in the background with backoff
+} ble_session_mode_t;
+
+// Mode used at boot. Builds that want the persistent link opt in with
+// -DBLE_SESSION_MODE_DEFAULT=BLE_SESSION_KEEP_ALIVE.
+#ifndef BLE_SESSION_MODE_DEFAULT
+#define BLE_SESSION_MODE_DEFAULT BLE_SESSION_ON_DEMAND
+#endif
+
 void ble_client_init();
+void ble_set_session_mode(ble_session_mode_t mode);
+ble_session_mode_t ble_get_session_mode();
+bool ble_is_connected(); // Link up (for power estimates; don't use it to gate writes)
 void ble_perform_initial_read(); // New function to be called from app_init
 void write_target_weight(int8_t weight);
+// Touch-down on a control that is about to write (a preset): starts connecting
+// now and resets the reconnect backoff. Never displaces a queued write.
+void ble_prepare_write();
 // internal_read_weight is not public
 // int8_t read_target_weight(); // This function was removed as it's internal now
 
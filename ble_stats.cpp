@@ -0,0 +1,148 @@
+/*
+ * BLE operation latency and link-quality statistics.
+ *
+ * Histograms use fixed, roughly logarithmic buckets from 1 ms to 10 s, so
+ * recording is a short scan under a spinlock and percentiles are reported as
+ * the upper bound of the bucket they fall in.
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "ble_stats.h"
+
+static const uint32_t bucket_upper_us[BLE_STATS_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 10000000,
+};
+
+static const char* const op_names[BLE_OP_COUNT] = {
+    "scan", "connect", "discovery", "write", "verify", "read", "end_to_end",
+};
+
+static const char* const counter_names[BLE_CNT_COUNT] = {
+    "connect_attempts", "connect_failures", "direct_fallbacks", "disconnects", "rediscoveries",
+    "write_failures", "verify_failures", "verify_readbacks", "read_failures",
+    "boot_read_retries", "reconnect_retries",
+};
+
+typedef struct {
+    uint32_t buckets[BLE_STATS_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+} ble_histogram_t;
+
+static ble_histogram_t histograms[BLE_OP_COUNT];
+static uint32_t counters[BLE_CNT_COUNT];
+static int8_t last_rssi = 0;
+static uint32_t generation = 0;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void ble_stats_record(ble_op_t op, uint32_t us) {
+    if (op >= BLE_OP_COUNT) return;
+    int bucket = 0;
+    while (bucket < BLE_STATS_BUCKETS - 1 && us > bucket_upper_us[bucket]) bucket++;
+
+    portENTER_CRITICAL(&stats_mux);
+    ble_histogram_t& h = histograms[op];
+    h.buckets[bucket]++;
+    h.count++;
+    h.total_us += us;
+    if (us > h.max_us) h.max_us = us;
+    generation++;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void ble_stats_record_since(ble_op_t op, int64_t start_us) {
+    ble_stats_record(op, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+void ble_stats_count(ble_counter_t counter) {
+    if (counter >= BLE_CNT_COUNT) return;
+    portENTER_CRITICAL(&stats_mux);
+    counters[counter]++;
+    generation++;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void ble_stats_set_rssi(int8_t rssi) {
+    portENTER_CRITICAL(&stats_mux);
+    if (rssi != last_rssi) generation++;
+    last_rssi = rssi;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// Upper bound of the bucket holding the given fraction of samples (max for the open bucket)
+static uint32_t percentile_us(const ble_histogram_t& h, uint32_t permille) {
+    if (h.count == 0) return 0;
+    uint32_t rank = (h.count * permille + 999) / 1000; // 1-based rank of the sample
+    uint32_t seen = 0;
+    for (int i = 0; i < BLE_STATS_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) {
+            if (i == BLE_STATS_BUCKETS - 1) return h.max_us;
+            return bucket_upper_us[i] < h.max_us ? bucket_upper_us[i] : h.max_us;
+        }
+    }
+    return h.max_us;
+}
+
+ble_op_summary_t ble_stats_summary(ble_op_t op) {
+    ble_op_summary_t s = {};
+    if (op >= BLE_OP_COUNT) return s;
+    portENTER_CRITICAL(&stats_mux);
+    const ble_histogram_t& h = histograms[op];
+    s.count = h.count;
+    s.p50_us = percentile_us(h, 500);
+    s.p95_us = percentile_us(h, 950);
+    s.max_us = h.max_us;
+    portEXIT_CRITICAL(&stats_mux);
+    return s;
+}
+
+uint32_t ble_stats_counter(ble_counter_t counter) {
+    return counter < BLE_CNT_COUNT ? counters[counter] : 0;
+}
+
+int8_t ble_stats_rssi() {
+    return last_rssi;
+}
+
+uint32_t ble_stats_generation() {
+    return generation;
+}
+
+void ble_stats_format(char* buf, size_t len) {
+    size_t used = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < BLE_OP_COUNT && used < len; i++) {
+        ble_op_summary_t s = ble_stats_summary((ble_op_t)i);
+        int n = snprintf(buf + used, len - used, "%s%s=%lu/%lu/%lu", i ? " " : "", op_names[i],
+                         (unsigned long)s.count, (unsigned long)(s.p50_us / 1000), (unsigned long)(s.p95_us / 1000));
+        if (n < 0) break;
+        used += (size_t)n;
+    }
+}
+
+void ble_stats_dump() {
+    Serial.printf("[%lu] BLE stats (RSSI %d dBm):\n", millis(), last_rssi);
+    for (int i = 0; i < BLE_OP_COUNT; i++) {
+        ble_histogram_t h;
+        portENTER_CRITICAL(&stats_mux);
+        h = histograms[i];
+        portEXIT_CRITICAL(&stats_mux);
+        if (h.count == 0) {
+            Serial.printf("  %-10s no samples\n", op_names[i]);
+            continue;
+        }
+        ble_op_summary_t s = ble_stats_summary((ble_op_t)i);
+        Serial.printf("  %-10s n=%lu avg=%.1f p50<=%.1f p95<=%.1f max=%.1f ms |", op_names[i], (unsigned long)h.count,
+                      h.total_us / 1000.0 / h.count, s.p50_us / 1000.0, s.p95_us / 1000.0, h.max_us / 1000.0);
+        for (int b = 0; b < BLE_STATS_BUCKETS; b++) {
+            Serial.printf(" %lu", (unsigned long)h.buckets[b]);
+        }
+        Serial.println();
+    }
+    for (int i = 0; i < BLE_CNT_COUNT; i++) {
+        Serial.printf("  %-18s %lu\n", counter_names[i], (unsigned long)counters[i]);
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * BLE operation latency and link-quality statistics.
+ *
+ * The BLE worker records the duration of every scan, connect, discovery,
+ * write, verify and read, plus the end-to-end time from a queued write to its
+ * verification. Each operation has a fixed-bucket histogram (no allocation),
+ * and failures and retries are counted. Read by the HA diagnostics and the
+ * "ble" serial command.
+ */
+#ifndef BLE_STATS_H
+#define BLE_STATS_H
+
+#include <cstdint>
+
+typedef enum {
+    BLE_OP_SCAN,
+    BLE_OP_CONNECT,     // Successful link setup (direct or after a scan)
+    BLE_OP_DISCOVERY,   // Service/characteristic/CCCD discovery
+    BLE_OP_WRITE,       // Write with response
+    BLE_OP_VERIFY,      // Notification echo or read-back after a write
+    BLE_OP_READ,
+    BLE_OP_END_TO_END,  // write_target_weight() -> verified
+    BLE_OP_COUNT
+} ble_op_t;
+
+typedef enum {
+    BLE_CNT_CONNECT_ATTEMPTS,
+    BLE_CNT_CONNECT_FAILURES,
+    BLE_CNT_DIRECT_FALLBACKS,   // Cached-address connect failed, fell back to a scan
+    BLE_CNT_DISCONNECTS,        // Disconnect events from the stack (includes on-demand drops)
+    BLE_CNT_REDISCOVERIES,      // Cached GATT handles turned out stale
+    BLE_CNT_WRITE_FAILURES,
+    BLE_CNT_VERIFY_FAILURES,
+    BLE_CNT_VERIFY_READBACKS,   // No echo in time, verified by reading back
+    BLE_CNT_READ_FAILURES,
+    BLE_CNT_BOOT_READ_RETRIES,
+    BLE_CNT_RECONNECT_RETRIES,  // Keep-alive reconnects that failed and backed off
+    BLE_CNT_COUNT
+} ble_counter_t;
+
+#define BLE_STATS_BUCKETS 12 // Upper bounds in ble_stats.cpp, last bucket is open-ended
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;  // Bucket upper bound containing the median
+    uint32_t p95_us;
+    uint32_t max_us;
+} ble_op_summary_t;
+
+void ble_stats_record(ble_op_t op, uint32_t us);
+void ble_stats_record_since(ble_op_t op, int64_t start_us); // start_us from esp_timer_get_time()
+void ble_stats_count(ble_counter_t counter);
+void ble_stats_set_rssi(int8_t rssi);
+
+ble_op_summary_t ble_stats_summary(ble_op_t op);
+uint32_t ble_stats_counter(ble_counter_t counter);
+int8_t ble_stats_rssi(); // Last sample, 0 if none yet
+uint32_t ble_stats_generation(); // Increments on every update, for change detection
+
+// Writes "op=n/p50/p95 ..." (ms) for every operation into buf
+void ble_stats_format(char* buf, size_t len);
+
+// Logs every histogram and counter
+void ble_stats_dump();
+
+#endif // BLE_STATS_H
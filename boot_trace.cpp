@@ -0,0 +1,91 @@
+/*
+ * Boot-phase timeline.
+ *
+ * Each mark stores the esp_timer time at which it was first reached. The
+ * summary is logged once when the last milestone arrives, or after
+ * BOOT_TRACE_TIMEOUT_MS with whatever was reached (e.g. no access point).
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "boot_trace.h"
+#include "app_log.h"
+
+#define BOOT_TRACE_TIMEOUT_MS 60000 // Log a partial timeline if boot never completes
+
+static const char* const mark_names[BOOT_MARK_COUNT] = {
+    "setup", "display", "first_frame", "encoder", "ble_init", "nvs",
+    "ha_init", "app_init", "wifi", "mqtt", "ble_sync",
+};
+
+static int64_t mark_us[BOOT_MARK_COUNT];   // 0 = not reached
+static uint32_t marks_reached = 0;         // Bitmask of reached marks
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t timeout_timer = NULL;
+
+#define BOOT_MARKS_ALL ((1UL << BOOT_MARK_COUNT) - 1)
+
+static void boot_trace_timeout_cb(void* arg) {
+    if (!boot_trace_complete()) {
+        LOG_W("Boot incomplete after %d ms", BOOT_TRACE_TIMEOUT_MS);
+        boot_trace_dump();
+    }
+}
+
+void boot_trace_mark(boot_mark_t mark) {
+    if (mark >= BOOT_MARK_COUNT || (marks_reached & (1UL << mark))) return; // Cheap early out on hot paths
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&boot_mux);
+    bool first = !(marks_reached & (1UL << mark));
+    if (first) {
+        mark_us[mark] = now;
+        marks_reached |= 1UL << mark;
+    }
+    bool completed = first && marks_reached == BOOT_MARKS_ALL;
+    portEXIT_CRITICAL(&boot_mux);
+
+    if (!first) return;
+    if (mark == BOOT_MARK_SETUP && timeout_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = &boot_trace_timeout_cb,
+            .name = "boot_trace"
+        };
+        if (esp_timer_create(&args, &timeout_timer) == ESP_OK) {
+            esp_timer_start_once(timeout_timer, (uint64_t)BOOT_TRACE_TIMEOUT_MS * 1000);
+        }
+    }
+    if (completed) {
+        boot_trace_dump();
+    }
+}
+
+int32_t boot_trace_get_ms(boot_mark_t mark) {
+    if (mark >= BOOT_MARK_COUNT) return -1;
+    portENTER_CRITICAL(&boot_mux);
+    int32_t ms = (marks_reached & (1UL << mark)) ? (int32_t)(mark_us[mark] / 1000) : -1;
+    portEXIT_CRITICAL(&boot_mux);
+    return ms;
+}
+
+bool boot_trace_complete(void) {
+    return marks_reached == BOOT_MARKS_ALL;
+}
+
+void boot_trace_format(char* buf, size_t len) {
+    size_t used = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < BOOT_MARK_COUNT && used < len; i++) {
+        int32_t ms = boot_trace_get_ms((boot_mark_t)i);
+        int n = ms >= 0 ? snprintf(buf + used, len - used, "%s%s=%ld", i ? " " : "", mark_names[i], (long)ms)
+                        : snprintf(buf + used, len - used, "%s%s=-", i ? " " : "", mark_names[i]);
+        if (n < 0) break;
+        used += (size_t)n;
+    }
+}
+
+void boot_trace_dump(void) {
+    char line[160]; // With the "[millis] Boot trace (ms): " prefix this fits APP_LOG_LINE_MAX
+    boot_trace_format(line, sizeof(line));
+    LOG_I("Boot trace (ms): %s", line);
+}
@@ -0,0 +1,54 @@
+/*
+ * Boot-phase timeline.
+ *
+ * Records the first time each boot milestone is reached (esp_timer_get_time(),
+ * so times are measured from reset) and logs it as one summary line once the
+ * device is fully up: first frame on the panel, Wi-Fi, MQTT and the first
+ * verified BLE weight. Safe to call from any task (not from ISRs).
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOOT_MARK_SETUP,        // setup() entered
+    BOOT_MARK_DISPLAY,      // lcd_lvgl_Init() done (screens built)
+    BOOT_MARK_FIRST_FRAME,  // Last band of the first frame handed to the panel DMA
+    BOOT_MARK_ENCODER,      // encoder_init() done
+    BOOT_MARK_BLE_INIT,     // ble_client_init() done
+    BOOT_MARK_NVS,          // Settings loaded from NVS
+    BOOT_MARK_HA_INIT,      // ha_init() done
+    BOOT_MARK_APP_INIT,     // app_init() returned
+    BOOT_MARK_WIFI,         // Wi-Fi associated with an IP
+    BOOT_MARK_MQTT,         // MQTT broker connected
+    BOOT_MARK_BLE_SYNC,     // First verified weight from the stopper
+    BOOT_MARK_COUNT
+} boot_mark_t;
+
+// Records a milestone; only the first call per mark counts
+void boot_trace_mark(boot_mark_t mark);
+
+// Milliseconds since reset at which the mark was reached, or -1
+int32_t boot_trace_get_ms(boot_mark_t mark);
+
+// True once every milestone has been reached
+bool boot_trace_complete(void);
+
+// Writes the one-line summary into buf ("-" for marks not reached yet)
+void boot_trace_format(char *buf, size_t len);
+
+// Logs the summary line now, complete or not
+void boot_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_TRACE_H
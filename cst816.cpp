@@ -1,35 +1,83 @@
+/*
+ * CST816 touch controller driver (I2C).
+ *
+ * The I2C helpers use stack buffers (no heap traffic per transfer) and a
+ * bounded timeout and return the esp_err_t of the transfer. If the build sets
+ * EXAMPLE_PIN_NUM_TOUCH_INT (polling by default), the controller's INT line
+ * triggers a GPIO interrupt so the UI only reads the chip when something is
+ * actually touching the screen.
+ */
 #include "cst816.h"
 #include "esp_err.h"
 #include "lcd_config.h"
 
 #define TEST_I2C_PORT I2C_NUM_0
+#define TOUCH_I2C_TIMEOUT_MS 20   // A 7-byte read at 300 kHz takes well under 1 ms
+#define TOUCH_I2C_WRITE_MAX 16    // Largest register payload we ever write
 
-uint8_t I2C_writr_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len)
+static touch_irq_cb_t touch_irq_cb = NULL;
+static void *touch_irq_arg = NULL;
+static bool touch_irq_enabled = false;
+
+esp_err_t I2C_writr_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len)
 {
-  uint8_t ret;
-  uint8_t *pbuf = (uint8_t*)malloc(len+1);
+  uint8_t pbuf[TOUCH_I2C_WRITE_MAX + 1];
+  if(len > TOUCH_I2C_WRITE_MAX)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
   pbuf[0] = reg;
   for(uint8_t i = 0; i<len; i++)
   {
     pbuf[i+1] = buf[i];
   }
-  ret = i2c_master_write_to_device(TEST_I2C_PORT,addr,pbuf,len+1,1000);
-  free(pbuf);
-  pbuf = NULL;
-  return ret;
+  return i2c_master_write_to_device(TEST_I2C_PORT,addr,pbuf,len+1,pdMS_TO_TICKS(TOUCH_I2C_TIMEOUT_MS));
 }
-uint8_t I2C_read_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len)
+esp_err_t I2C_read_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len)
 {
-  uint8_t ret;
-  ret = i2c_master_write_read_device(TEST_I2C_PORT,addr,&reg,1,buf,len,1000);
+  esp_err_t ret;
+  ret = i2c_master_write_read_device(TEST_I2C_PORT,addr,&reg,1,buf,len,pdMS_TO_TICKS(TOUCH_I2C_TIMEOUT_MS));
   return ret;
 }
-uint8_t I2C_master_write_read_device(uint8_t addr,uint8_t *writeBuf,uint8_t writeLen,uint8_t *readBuf,uint8_t readLen)
+esp_err_t I2C_master_write_read_device(uint8_t addr,uint8_t *writeBuf,uint8_t writeLen,uint8_t *readBuf,uint8_t readLen)
 {
-  uint8_t ret;
-  ret = i2c_master_write_read_device(TEST_I2C_PORT,addr,writeBuf,writeLen,readBuf,readLen,1000);
+  esp_err_t ret;
+  ret = i2c_master_write_read_device(TEST_I2C_PORT,addr,writeBuf,writeLen,readBuf,readLen,pdMS_TO_TICKS(TOUCH_I2C_TIMEOUT_MS));
   return ret;
 }
+
+// INT falls on every touch report; hand off to whoever registered (the LVGL task)
+static void IRAM_ATTR touch_int_isr(void *arg)
+{
+  if(touch_irq_cb && touch_irq_cb(touch_irq_arg))
+  {
+    portYIELD_FROM_ISR();
+  }
+}
+
+static void touch_int_init(void)
+{
+#if EXAMPLE_PIN_NUM_TOUCH_INT >= 0
+  gpio_config_t io_conf = {
+    .pin_bit_mask = (1ULL << EXAMPLE_PIN_NUM_TOUCH_INT),
+    .mode = GPIO_MODE_INPUT,
+    .pull_up_en = GPIO_PULLUP_ENABLE,
+    .pull_down_en = GPIO_PULLDOWN_DISABLE,
+    .intr_type = GPIO_INTR_NEGEDGE,
+  };
+  if(gpio_config(&io_conf) != ESP_OK)
+  {
+    return;
+  }
+  esp_err_t err = gpio_install_isr_service(0);
+  if(err != ESP_OK && err != ESP_ERR_INVALID_STATE) // Already installed is fine
+  {
+    return;
+  }
+  touch_irq_enabled = (gpio_isr_handler_add((gpio_num_t)EXAMPLE_PIN_NUM_TOUCH_INT, touch_int_isr, NULL) == ESP_OK);
+#endif
+}
+
 void Touch_Init(void)
 {
   i2c_config_t conf = 
@@ -47,12 +95,26 @@ void Touch_Init(void)
 
   uint8_t data = 0x00;
   I2C_writr_buff(EXAMPLE_TOUCH_ADDR,0x00,&data,1); //Switch to normal mode
+
+  touch_int_init();
+}
+bool Touch_IrqEnabled(void)
+{
+  return touch_irq_enabled;
+}
+void Touch_SetIrqCallback(touch_irq_cb_t cb, void *arg)
+{
+  touch_irq_arg = arg;
+  touch_irq_cb = cb;
 }
 uint8_t getTouch(uint16_t *x,uint16_t *y)
 {
   uint8_t GetNum = 0;
   uint8_t data[7] = {0};
-  I2C_read_buff(EXAMPLE_TOUCH_ADDR,0x00,data,7);
+  if(I2C_read_buff(EXAMPLE_TOUCH_ADDR,0x00,data,7) != ESP_OK)
+  {
+    return 0;
+  }
   GetNum = data[2];
   if(GetNum)
   {
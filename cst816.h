@@ -6,8 +6,22 @@
 extern "C" {
 #endif 
 
+// Touch INT callback, runs in ISR context; return true if a higher-priority task was woken
+typedef bool (*touch_irq_cb_t)(void *arg);
+
+// Register-level I2C access to the touch controller (bounded timeout)
+esp_err_t I2C_writr_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len);
+esp_err_t I2C_read_buff(uint8_t addr,uint8_t reg,uint8_t *buf,uint8_t len);
+esp_err_t I2C_master_write_read_device(uint8_t addr,uint8_t *writeBuf,uint8_t writeLen,uint8_t *readBuf,uint8_t readLen);
+
 void Touch_Init(void);
 
+// True if the INT line is wired and its interrupt is installed
+bool Touch_IrqEnabled(void);
+
+// Register the callback fired on each touch report (INT falling edge)
+void Touch_SetIrqCallback(touch_irq_cb_t cb, void *arg);
+
 uint8_t getTouch(uint16_t *x,uint16_t *y);
 
 #ifdef __cplusplus
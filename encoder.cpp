@@ -1,15 +1,16 @@
 /*
  * Rotary encoder implementation.
  *
- * Handles knob rotation events. Routes events to either the Shot Stopper
- * weight control or the Home Assistant UI handler based on the active screen.
+ * The knob uses the PCNT backend, so the CPU only wakes when it moves. Knob
+ * callbacks only accumulate detents, estimate the turn rate and wake the
+ * display if it is asleep; encoder_ui_poll() (an LVGL timer) applies one
+ * velocity-scaled step per UI frame, using a per-control gain curve, to the
+ * Shot Stopper weight or the Home Assistant control depending on the active
+ * screen. Each batch also calls reset_inactivity_timer().
  *
- * Implements a 1-second debounce timer (ble_write_timer) for the Shot Stopper
- * screen to prevent rapid, successive BLE write requests. The UI is updated
- * instantly, but the BLE write is only triggered after the user stops
- * turning the knob for 1 second.
- * Calls reset_inactivity_timer() on encoder turn.
- * Corrected ble_write_timer definition (removed static).
+ * On the Shot Stopper screen the label is updated instantly, but the BLE
+ * write only goes out once the knob has been still for 1 second
+ * (ble_write_timer), so a turn doesn't produce a stream of writes.
  */
 
 #include <Arduino.h>
@@ -18,6 +19,10 @@
 #include "ble_client.h" // Include BLE client for write_target_weight
 #include "lvgl_display.h" // Include display header AFTER lvgl.h
 #include "bidi_switch_knob.h" // Make sure this is the correct header name
+#include "lcd_bsp.h" // lcd_display_wake()
+#include "app_log.h"
+#include <esp_timer.h>
+#include <math.h>
 
 
 // External variable for the target weight (used by Shot Stopper screen)
@@ -31,6 +36,27 @@ TimerHandle_t ble_write_timer = NULL;
 #define ENCODER_PIN_A 8
 #define ENCODER_PIN_B 7
 
+// Velocity estimate: detents further apart than this start a new spin
+#define ENCODER_RATE_RESET_US 250000
+
+// Gain curves: 1 step per detent up to rate_lo detents/s, ramping to max_gain at rate_hi
+static const encoder_gain_curve_t GAIN_WEIGHT = {6.0f, 25.0f, 3.0f}; // Grams
+static const encoder_gain_curve_t GAIN_HA[] = {
+    /* HA_CONTROL_NONE */        {0.0f, 1.0f, 1.0f},
+    /* HA_CONTROL_MODE */        {0.0f, 1.0f, 1.0f},  // Discrete, no acceleration
+    /* HA_CONTROL_PREINF_TIME */ {6.0f, 25.0f, 3.0f}, // 0.1 s steps
+    /* HA_CONTROL_TEMP */        {6.0f, 25.0f, 5.0f}, // 0.1 C steps
+    /* HA_CONTROL_STEAM */       {0.0f, 1.0f, 1.0f},
+    /* HA_CONTROL_BACKFLUSH */   {0.0f, 1.0f, 1.0f},
+};
+
+// Detents accumulated by the knob task, drained by encoder_ui_poll()
+static portMUX_TYPE encoder_mux = portMUX_INITIALIZER_UNLOCKED;
+static int32_t pending_detents = 0;
+static float detent_rate = 0;      // Detents per second (smoothed)
+static int64_t last_detent_us = 0;
+static int8_t last_direction = 0;
+
 // Forward declaration for the HA screen encoder handler
 // extern void ha_ui_handle_encoder_turn(int8_t direction); // Declared in lvgl_display.h
 // Forward declaration for the HA screen timer reset
@@ -39,51 +65,84 @@ TimerHandle_t ble_write_timer = NULL;
 // Callback function for the BLE write timer
 // This function is called 1 second *after* the last encoder turn
 static void ble_write_timer_callback(TimerHandle_t xTimer) {
-    Serial.printf("[%lu] BLE write timer expired. Writing final weight: %d\n", millis(), target_weight);
+    LOG_I("BLE write timer expired. Writing final weight: %d", target_weight);
     write_target_weight(target_weight); // Call the actual BLE write function
 }
 
-// Callback for left rotation
-static void knob_left_cb(void* arg, void* data) {
-    reset_inactivity_timer(); // Reset brightness/inactivity timer
+// Accumulates one detent; runs in the knob task. No UI work happens here.
+static void knob_accumulate(int8_t direction) {
+    int64_t now = esp_timer_get_time();
 
-    lv_obj_t* current_screen = lv_scr_act(); // Get the currently active screen
+    portENTER_CRITICAL(&encoder_mux);
+    // Reversing direction restarts the velocity estimate
+    if ((direction > 0) != (last_direction > 0) || now - last_detent_us > ENCODER_RATE_RESET_US) {
+        detent_rate = 0;
+    } else {
+        float instant = 1000000.0f / (float)(now - last_detent_us);
+        detent_rate = detent_rate == 0 ? instant : detent_rate * 0.5f + instant * 0.5f;
+    }
+    last_detent_us = now;
+    last_direction = direction;
+    pending_detents += direction;
+    portEXIT_CRITICAL(&encoder_mux);
 
-    if (current_screen == screen_shot_stopper) {
-        target_weight--;
-        Serial.printf("Encoder left (Shot Stopper). New target weight: %d\n", target_weight);
-        hide_verification_checkmark();
-        update_display_value(target_weight); // Update UI immediately
+    lcd_display_wake(); // The UI poll timer doesn't run while the display sleeps
+}
 
-        // Don't write yet, just reset the debounce timer
-        if (ble_write_timer != NULL) {
-            xTimerReset(ble_write_timer, portMAX_DELAY); // Reset timer to 1 second
-        }
-    } else if (current_screen == screen_ha) {
-        Serial.println("Encoder left (HA Screen).");
-        ha_ui_handle_encoder_turn(-1); // Pass direction -1 for left turn
-    }
+// Callback for left rotation
+static void knob_left_cb(void* arg, void* data) {
+    knob_accumulate(-1);
 }
 
 // Callback for right rotation
 static void knob_right_cb(void* arg, void* data) {
-     reset_inactivity_timer(); // Reset brightness/inactivity timer
+    knob_accumulate(1);
+}
+
+// Scales a batch of detents by the control's gain curve
+static int32_t apply_gain(int32_t detents, float rate, const encoder_gain_curve_t* curve) {
+    float gain = 1.0f;
+    if (curve->max_gain > 1.0f && rate > curve->rate_lo) {
+        float t = (rate - curve->rate_lo) / (curve->rate_hi - curve->rate_lo);
+        if (t > 1.0f) t = 1.0f;
+        gain = 1.0f + t * (curve->max_gain - 1.0f);
+    }
+    return (int32_t)lroundf((float)detents * gain);
+}
+
+void encoder_ui_poll() {
+    portENTER_CRITICAL(&encoder_mux);
+    int32_t detents = pending_detents;
+    float rate = detent_rate;
+    pending_detents = 0;
+    portEXIT_CRITICAL(&encoder_mux);
+
+    if (detents == 0) return;
 
-     lv_obj_t* current_screen = lv_scr_act(); // Get the currently active screen
+    reset_inactivity_timer(); // Reset brightness/inactivity timer
+
+    lv_obj_t* current_screen = lv_scr_act(); // Get the currently active screen
 
     if (current_screen == screen_shot_stopper) {
-        target_weight++;
-        Serial.printf("Encoder right (Shot Stopper). New target weight: %d\n", target_weight);
+        int32_t weight = target_weight + apply_gain(detents, rate, &GAIN_WEIGHT);
+        if (weight < 0) weight = 0;
+        if (weight > INT8_MAX) weight = INT8_MAX;
+        target_weight = (int8_t)weight;
+        LOG_D("Encoder %+ld detents at %.1f/s (Shot Stopper). New target weight: %d", (long)detents, rate, target_weight);
         hide_verification_checkmark();
-        update_display_value(target_weight); // Update UI immediately
+        update_display_value(target_weight); // One label update per batch
 
         // Don't write yet, just reset the debounce timer
         if (ble_write_timer != NULL) {
-            xTimerReset(ble_write_timer, portMAX_DELAY); // Reset timer to 1 second
+            xTimerReset(ble_write_timer, 0); // Reset timer to 1 second
         }
-    } else if (current_screen == screen_ha) {
-         Serial.println("Encoder right (HA Screen).");
-         ha_ui_handle_encoder_turn(1); // Pass direction 1 for right turn
+    } else if (screen_ha && current_screen == screen_ha) { // screen_ha is NULL until built
+        ha_control_t control = ha_ui_get_selected_control();
+        int32_t steps = apply_gain(detents, rate, &GAIN_HA[control]);
+        if (steps > INT8_MAX) steps = INT8_MAX;
+        if (steps < -INT8_MAX) steps = -INT8_MAX;
+        LOG_D("Encoder %+ld detents at %.1f/s (HA Screen), %+ld steps.", (long)detents, rate, (long)steps);
+        ha_ui_handle_encoder_turn((int8_t)steps);
     }
 }
 
@@ -92,14 +151,15 @@ void encoder_init() {
     knob_config_t cfg = {
         .gpio_encoder_a = ENCODER_PIN_A,
         .gpio_encoder_b = ENCODER_PIN_B,
+        .backend = KNOB_BACKEND_PCNT, // Falls back to the 3 ms poll if PCNT can't be set up
     };
     knob_handle_t s_knob = iot_knob_create(&cfg);
     if (s_knob) {
         iot_knob_register_cb(s_knob, KNOB_LEFT, knob_left_cb, NULL);
         iot_knob_register_cb(s_knob, KNOB_RIGHT, knob_right_cb, NULL);
-        Serial.println("Rotary encoder initialized successfully.");
+        LOG_I("Rotary encoder initialized successfully.");
     } else {
-        Serial.println("Failed to initialize rotary encoder.");
+        LOG_W("Failed to initialize rotary encoder.");
     }
 
     // Create the one-shot timer for debouncing BLE writes. 1000ms delay.
@@ -111,9 +171,9 @@ void encoder_init() {
                                    ble_write_timer_callback); // Callback function
 
     if (ble_write_timer == NULL) {
-        Serial.println("Failed to create ble_write_timer!");
+        LOG_W("Failed to create ble_write_timer!");
     } else {
-        Serial.println("BLE write debounce timer created.");
+        LOG_I("BLE write debounce timer created.");
     }
 }
 
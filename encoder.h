@@ -1,7 +1,7 @@
 /*
  * Header for the rotary encoder module.
- * Declares the initialization function.
- * Exposes the BLE write timer handle.
+ * Declares the initialization function and exposes the BLE write debounce
+ * timer. encoder_ui_poll() applies accumulated knob turns on the LVGL task.
  */
 #ifndef ENCODER_H
 #define ENCODER_H
@@ -11,7 +11,18 @@
 // Make the BLE write timer handle available externally
 extern TimerHandle_t ble_write_timer;
 
+// Per-control acceleration: steps per detent ramp from 1 to max_gain
+// as the turn rate goes from rate_lo to rate_hi detents/second
+typedef struct {
+    float rate_lo;
+    float rate_hi;
+    float max_gain;
+} encoder_gain_curve_t;
+
 void encoder_init();
 
+// Applies all detents since the last call as one scaled step (call from the LVGL context)
+void encoder_ui_poll();
+
 #endif // ENCODER_H
 
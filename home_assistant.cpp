@@ -1,18 +1,45 @@
 /*
  * Home Assistant integration logic.
  *
- * Handles connecting to WiFi, MQTT broker, and managing
- * Home Assistant entities (switch, select, button, numbers, sensor).
- * Corrected ambiguous setState call, HASelect options format,
- * and removed inaccessible variables from publish function.
- * Corrected HANumeric::toInt() to toInt8().
+ * Manages the Wi-Fi and MQTT connection and the Home Assistant entities
+ * (switches, select, numbers, sensors).
+ *
+ * Wi-Fi and MQTT are brought up by a background network task running a
+ * small state machine with exponential backoff, so boot, the UI and the
+ * BLE sync never wait on the access point or the broker. The task is pinned
+ * to the radio core and pumps mqtt.loop() at a fixed cadence. Inbound HA
+ * commands are posted to the event bus and applied to the UI by the LVGL task.
+ *
+ * Outbound states go through per-entity publish slots: knob-driven values
+ * are debounced and deduplicated and only the latest one is published
+ * after a quiet period; power and backflush are flushed on the next tick.
+ * The boot timeline, BLE latency and failure diagnostics, and heap, LVGL and
+ * stack telemetry are published as diagnostic sensors at a slow cadence.
+ * Each HA shot duration closes a shot session, uploaded as one sensor update.
  */
 
 #include <WiFi.h>
 #include <ArduinoHA.h> // ArduinoHA library
 #include "secrets.h"    // For credentials - MAKE SURE MQTT_SERVER IS DEFINED HERE!
 #include "home_assistant.h"
-#include "lvgl_display.h" // To update UI based on HA commands
+#include "app_events.h" // net_status_t, event bus
+#include "task_config.h"
+#include "boot_trace.h"
+#include "ble_stats.h"
+#include "telemetry.h"
+#include "shot_session.h"
+#include "app_log.h"
+
+// Network bring-up timing
+#define WIFI_CONNECT_TIMEOUT_MS 15000  // Give up on one association attempt after this
+#define WIFI_BACKOFF_MIN_MS 1000       // Retry delay after the first failure (doubles)
+#define WIFI_BACKOFF_MAX_MS 60000
+#define MQTT_BACKOFF_MIN_MS 10000      // Matches ArduinoHA's own reconnect interval
+#define MQTT_BACKOFF_MAX_MS 120000
+#define HA_NETWORK_POLL_MS 20          // State machine / mqtt.loop() cadence
+#define HA_PUBLISH_QUIET_MS 750        // Publish a knob-driven value once it has been still this long
+#define HA_MAX_ENTITIES 24             // HAMqtt entity table size (library default is 6)
+#define HA_DIAG_PERIOD_MS 60000        // Diagnostics are published at most this often, and only on change
 
 // WiFi and MQTT credentials (from secrets.h)
 const char* ssid = WIFI_SSID;
@@ -24,7 +51,7 @@ const char* mqtt_password = MQTT_PASSWORD;
 
 WiFiClient client;
 HADevice device("esp32_linea_micra_ctrl"); // Unique device name
-HAMqtt mqtt(client, device);
+HAMqtt mqtt(client, device, HA_MAX_ENTITIES);
 
 // Define HA entities
 HASwitch machinePower("linea_micra_power"); // Unique ID for the power switch
@@ -35,14 +62,192 @@ HANumber steamPower("linea_micra_steam_power", HANumber::PrecisionP0); // Unique
 HANumber preinfusionTime("linea_micra_preinfusion_time", HANumber::PrecisionP1); // Unique ID, PrecisionP1 for 0.1
 HANumber lastShotDuration("linea_micra_last_shot", HANumber::PrecisionP1); // Changed to HANumber to receive updates
 
+// Diagnostics
+HASensor bootTrace("linea_micra_boot_trace");           // Full boot timeline (one line)
+HASensorNumber bootSyncTime("linea_micra_boot_sync_ms"); // Reset to first verified BLE weight, ms
+static bool boot_trace_published = false;
+HASensor bleLatency("linea_micra_ble_latency");         // "op=count/p50/p95" in ms for each BLE operation
+HASensorNumber bleEndToEndP95("linea_micra_ble_e2e_p95"); // Queued write -> verified, ms
+HASensorNumber bleRssi("linea_micra_ble_rssi");
+HASensorNumber bleFailures("linea_micra_ble_failures");   // Connect + write + verify failures
+static uint32_t ble_stats_published_gen = 0;
+static uint32_t diag_published_at = 0;
+HASensorNumber heapInternalFree("linea_micra_heap_internal");
+HASensorNumber heapInternalLargest("linea_micra_heap_internal_blk");
+HASensorNumber heapPsramFree("linea_micra_heap_psram");
+HASensorNumber lvglMemUsed("linea_micra_lvgl_mem_used");
+HASensor stackHeadroom("linea_micra_stack_headroom");   // Min-ever bytes per task
+HASensor memMinima("linea_micra_mem_minima");           // Min-ever heap values and reset info
+
+// Shot history
+HASensor shotSession("linea_micra_shot_session");       // Last shot: duration, target and the events leading up to it
+static uint32_t telemetry_published_gen = 0;
+static uint32_t telemetry_published_at = 0;
+
+// Network state (owned by the network task)
+static TaskHandle_t networkTaskHandle = NULL;
+static net_status_t net_status = NET_STATUS_OFFLINE;
+
+// Outbound publish slots, written by the UI and flushed by the network task
+typedef enum {
+    HA_PUB_POWER,
+    HA_PUB_MODE,
+    HA_PUB_TEMPERATURE,
+    HA_PUB_STEAM_POWER,
+    HA_PUB_PREINFUSION_TIME,
+    HA_PUB_BACKFLUSH,
+    HA_PUB_COUNT
+} ha_publish_slot_id_t;
+
+typedef struct {
+    float pending;       // Latest value requested by the UI
+    float published;     // Last value known to HA (NAN = unknown)
+    uint32_t changed_at; // millis() of the last change to pending
+    bool dirty;          // pending still needs to go out
+    bool immediate;      // Skip the quiet period (discrete actions)
+    bool force;          // Publish even if equal to published (momentary actions)
+} ha_publish_slot_t;
+
+static ha_publish_slot_t publish_slots[HA_PUB_COUNT];
+static portMUX_TYPE publish_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void ha_publish_initial_states();
+
 // Preinfusion mode options - Not used directly by setOptions anymore
 // const char* modes[] = {"Pre-brew", "Pre-infusion", "Disabled"};
 
+// --- Publish Slots ---
+
+// Records a new outbound value. Called from the UI; never publishes directly.
+static void queue_publish(ha_publish_slot_id_t id, float value, bool immediate, bool force = false) {
+    portENTER_CRITICAL(&publish_mux);
+    ha_publish_slot_t& slot = publish_slots[id];
+    slot.pending = value;
+    slot.changed_at = millis();
+    slot.dirty = force || value != slot.published;
+    slot.immediate = immediate;
+    slot.force = force;
+    portEXIT_CRITICAL(&publish_mux);
+}
+
+// Records a value that came from HA so it is not echoed back.
+static void note_remote_state(ha_publish_slot_id_t id, float value) {
+    portENTER_CRITICAL(&publish_mux);
+    ha_publish_slot_t& slot = publish_slots[id];
+    slot.published = value;
+    if (slot.dirty && !slot.force && slot.pending == value) {
+        slot.dirty = false;
+    }
+    portEXIT_CRITICAL(&publish_mux);
+}
+
+static bool publish_slot_value(ha_publish_slot_id_t id, float value, bool force) {
+    switch (id) {
+        case HA_PUB_POWER:            return machinePower.setState(value != 0, force);
+        case HA_PUB_MODE:             return preinfusionMode.setState((int8_t)value, force);
+        case HA_PUB_TEMPERATURE:      return targetTemperature.setState(value, force);
+        case HA_PUB_STEAM_POWER:      return steamPower.setState((int8_t)value, force);
+        case HA_PUB_PREINFUSION_TIME: return preinfusionTime.setState(value, force);
+        case HA_PUB_BACKFLUSH:        return backflushSwitch.setState(value != 0, force);
+        default:                      return false;
+    }
+}
+
+// Publishes every slot that is due. Runs on the network task while MQTT is connected.
+static void flush_publish_slots(uint32_t now) {
+    for (int i = 0; i < HA_PUB_COUNT; i++) {
+        ha_publish_slot_id_t id = (ha_publish_slot_id_t)i;
+        float value;
+        bool force;
+
+        portENTER_CRITICAL(&publish_mux);
+        ha_publish_slot_t& slot = publish_slots[i];
+        bool due = slot.dirty && (slot.immediate || now - slot.changed_at >= HA_PUBLISH_QUIET_MS);
+        value = slot.pending;
+        force = slot.force;
+        portEXIT_CRITICAL(&publish_mux);
+
+        if (!due) continue;
+
+        if (publish_slot_value(id, value, force)) {
+            portENTER_CRITICAL(&publish_mux);
+            // Only clear if the UI did not change the value while we were publishing
+            if (slot.pending == value) {
+                slot.dirty = false;
+                slot.force = false;
+            }
+            slot.published = value;
+            portEXIT_CRITICAL(&publish_mux);
+        }
+        // On failure the slot stays dirty and is retried on the next tick
+    }
+}
+
+// Publishes the boot timeline once every milestone is in. Runs on the network task.
+static void publish_boot_trace() {
+    if (boot_trace_published || !boot_trace_complete()) return;
+    char line[224];
+    boot_trace_format(line, sizeof(line));
+    boot_trace_published = bootTrace.setValue(line) &&
+                           bootSyncTime.setValue((int32_t)boot_trace_get_ms(BOOT_MARK_BLE_SYNC));
+}
+
+// Publishes the BLE diagnostics when they changed, at most every HA_DIAG_PERIOD_MS. Network task.
+static void publish_ble_stats(uint32_t now) {
+    uint32_t gen = ble_stats_generation();
+    if (gen == ble_stats_published_gen || (diag_published_at != 0 && now - diag_published_at < HA_DIAG_PERIOD_MS)) return;
+    char line[160];
+    ble_stats_format(line, sizeof(line));
+    uint32_t failures = ble_stats_counter(BLE_CNT_CONNECT_FAILURES) + ble_stats_counter(BLE_CNT_WRITE_FAILURES) +
+                        ble_stats_counter(BLE_CNT_VERIFY_FAILURES);
+    bool ok = bleLatency.setValue(line);
+    ok = bleEndToEndP95.setValue((int32_t)(ble_stats_summary(BLE_OP_END_TO_END).p95_us / 1000)) && ok;
+    ok = bleRssi.setValue((int32_t)ble_stats_rssi()) && ok;
+    ok = bleFailures.setValue((int32_t)failures) && ok;
+    if (ok) {
+        ble_stats_published_gen = gen;
+        diag_published_at = now;
+    }
+}
+
+// Publishes the memory telemetry, at most every HA_DIAG_PERIOD_MS. Network task.
+static void publish_telemetry(uint32_t now) {
+    uint32_t gen = telemetry_generation();
+    if (gen == telemetry_published_gen || (telemetry_published_at != 0 && now - telemetry_published_at < HA_DIAG_PERIOD_MS)) return;
+    telemetry_snapshot_t s = telemetry_get();
+    char line[256];
+    bool ok = heapInternalFree.setValue((int32_t)s.internal_free);
+    ok = heapInternalLargest.setValue((int32_t)s.internal_largest) && ok;
+    ok = heapPsramFree.setValue((int32_t)s.psram_free) && ok;
+    ok = lvglMemUsed.setValue((int32_t)s.lv_used_pct) && ok;
+    telemetry_format_stacks(line, sizeof(line));
+    ok = stackHeadroom.setValue(line) && ok;
+    telemetry_format_minima(line, sizeof(line));
+    ok = memMinima.setValue(line) && ok;
+    if (ok) {
+        telemetry_published_gen = gen;
+        telemetry_published_at = now;
+    }
+}
+
+// Uploads the last closed shot session as one message. Network task.
+static void publish_shot_session() {
+    char line[256];
+    uint16_t seq;
+    if (!shot_session_format_pending(line, sizeof(line), &seq)) return;
+    if (shotSession.setValue(line)) {
+        shot_session_mark_uploaded(seq); // Otherwise retried on the next tick
+    }
+}
+
 // --- Callback Functions for HA Commands ---
+// These run on the network task (inside mqtt.loop()). They acknowledge the
+// state back to HA and post the change to the event bus; they never touch LVGL.
 
 void onPowerSwitchCommand(bool state, HASwitch* sender) {
-    Serial.printf("Received power command from HA: %s\n", state ? "ON" : "OFF");
-    update_ha_power_switch_ui(state);
+    LOG_I("Received power command from HA: %s", state ? "ON" : "OFF");
+    note_remote_state(HA_PUB_POWER, state);
+    app_events_post_bool(APP_EVT_HA_POWER, state);
     // You'll need an automation in HA to link this switch to the actual machine power control
 }
 
@@ -50,17 +255,19 @@ void onModeSelectCommand(int8_t index, HASelect* sender) {
     // Assuming modes array has 3 elements
     const char* modes_lookup[] = {"Pre-brew", "Pre-infusion", "Disabled"}; // Local lookup
     if (index >= 0 && index < 3) {
-        Serial.printf("Received mode command from HA: %s (index %d)\n", modes_lookup[index], index);
+        LOG_I("Received mode command from HA: %s (index %d)", modes_lookup[index], index);
         sender->setCurrentState(index); // Acknowledge the state change back to HA
-        update_ha_mode_ui(index);
+        note_remote_state(HA_PUB_MODE, index);
+        app_events_post_int(APP_EVT_HA_MODE, index);
     } else {
-        Serial.printf("Received invalid mode index from HA: %d\n", index);
+        LOG_W("Received invalid mode index from HA: %d", index);
     }
 }
 
 // Callback for the backflush switch (likely won't be called if controlled from ESP)
 void onBackflushCommand(bool state, HASwitch* sender) {
-     Serial.printf("Received backflush command from HA: %s\n", state ? "ON" : "OFF");
+    LOG_I("Received backflush command from HA: %s", state ? "ON" : "OFF");
+    note_remote_state(HA_PUB_BACKFLUSH, state);
     // This callback might not be strictly needed if only triggering from ESP,
     // but good practice to include.
     // The HA automation should turn this switch off automatically.
@@ -69,9 +276,10 @@ void onBackflushCommand(bool state, HASwitch* sender) {
 
 void onTargetTempCommand(HANumeric number, HANumber* sender) {
     float temp = number.toFloat();
-    Serial.printf("Received target temperature command from HA: %.1f\n", temp);
+    LOG_I("Received target temperature command from HA: %.1f", temp);
     sender->setState(temp); // Acknowledge state back to HA
-    update_ha_temperature_ui(temp);
+    note_remote_state(HA_PUB_TEMPERATURE, temp);
+    app_events_post_float(APP_EVT_HA_TEMPERATURE, temp);
 }
 
 void onSteamPowerCommand(HANumeric number, HANumber* sender) {
@@ -79,43 +287,148 @@ void onSteamPowerCommand(HANumeric number, HANumber* sender) {
     int8_t power = number.toInt8();
 
     if (power >= 1 && power <= 3) {
-        Serial.printf("Received steam power command from HA: %d\n", power);
+        LOG_I("Received steam power command from HA: %d", power);
         // Corrected: Explicitly cast to int8_t to resolve ambiguity
         sender->setState((int8_t)power); // Acknowledge state back to HA
-        update_ha_steam_power_ui(power);
+        note_remote_state(HA_PUB_STEAM_POWER, power);
+        app_events_post_int(APP_EVT_HA_STEAM_POWER, power);
     } else {
          // Corrected: Use toInt8() in the logging statement as well
-         Serial.printf("Received invalid steam power value from HA: %d\n", (int)number.toInt8()); // Log original value
+         LOG_W("Received invalid steam power value from HA: %d", (int)number.toInt8()); // Log original value
     }
 }
 
 void onPreinfusionTimeCommand(HANumeric number, HANumber* sender) {
     float time = number.toFloat();
-    Serial.printf("Received preinfusion time command from HA: %.1f\n", time);
+    LOG_I("Received preinfusion time command from HA: %.1f", time);
     sender->setState(time); // Acknowledge state back to HA
-    update_ha_preinfusion_time_ui(time);
+    note_remote_state(HA_PUB_PREINFUSION_TIME, time);
+    app_events_post_float(APP_EVT_HA_PREINFUSION_TIME, time);
 }
 
 // Callback for when HA sends updates FOR the last shot duration
 void onLastShotUpdate(HANumeric number, HANumber* sender) {
     float duration = number.toFloat();
-    Serial.printf("Received last shot update from HA: %.1fs\n", duration);
+    LOG_I("Received last shot update from HA: %.1fs", duration);
     // No need to set state back to HA for a sensor-like input
-    update_ha_last_shot_ui(duration);
+    app_events_post_float(APP_EVT_HA_LAST_SHOT, duration);
+    shot_session_end(duration); // Closes the session; uploaded by publish_shot_session()
+}
+
+// --- MQTT Connection Callbacks ---
+
+void onMqttConnected() {
+    LOG_I("MQTT connected.");
+    boot_trace_mark(BOOT_MARK_MQTT);
+    boot_trace_published = false; // Re-publish diagnostics after a reconnect
+    ble_stats_published_gen = 0;
+    diag_published_at = 0;
+    telemetry_published_gen = 0;
+    telemetry_published_at = 0;
+    ha_publish_initial_states();
+}
+
+void onMqttDisconnected() {
+    LOG_W("MQTT disconnected.");
+}
+
+// --- Network State Machine ---
+
+static void set_net_status(net_status_t status) {
+    if (status == net_status) return;
+    net_status = status;
+    app_events_post_int(APP_EVT_NET_STATUS, status); // Applied by the LVGL task
+}
+
+// Background task that brings up and maintains Wi-Fi and MQTT.
+// OFFLINE -> WIFI_CONNECTING -> MQTT_CONNECTING -> ONLINE, with
+// exponential backoff on both the access point and the broker.
+static void ha_network_task(void* pvParameters) {
+    uint32_t wifi_backoff_ms = WIFI_BACKOFF_MIN_MS;
+    uint32_t mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+    uint32_t attempt_started = 0;
+    uint32_t retry_at = 0; // 0 = retry now
+    uint32_t mqtt_retry_at = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (true) {
+        uint32_t now = millis();
+
+        switch (net_status) {
+            case NET_STATUS_OFFLINE:
+                if ((int32_t)(now - retry_at) >= 0) {
+                    LOG_I("Connecting to WiFi...");
+                    WiFi.begin(ssid, password);
+                    attempt_started = now;
+                    set_net_status(NET_STATUS_WIFI_CONNECTING);
+                }
+                break;
+
+            case NET_STATUS_WIFI_CONNECTING:
+                if (WiFi.status() == WL_CONNECTED) {
+                    LOG_I("WiFi connected. IP address: %s", WiFi.localIP().toString().c_str());
+                    boot_trace_mark(BOOT_MARK_WIFI);
+                    wifi_backoff_ms = WIFI_BACKOFF_MIN_MS;
+                    mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+                    mqtt_retry_at = now;
+                    set_net_status(NET_STATUS_MQTT_CONNECTING);
+                } else if (now - attempt_started > WIFI_CONNECT_TIMEOUT_MS) {
+                    LOG_W("WiFi connect timed out. Retrying in %lu ms.", (unsigned long)wifi_backoff_ms);
+                    WiFi.disconnect();
+                    retry_at = now + wifi_backoff_ms;
+                    wifi_backoff_ms = min<uint32_t>(wifi_backoff_ms * 2, WIFI_BACKOFF_MAX_MS);
+                    set_net_status(NET_STATUS_OFFLINE);
+                }
+                break;
+
+            case NET_STATUS_MQTT_CONNECTING:
+            case NET_STATUS_ONLINE:
+                if (WiFi.status() != WL_CONNECTED) {
+                    LOG_W("WiFi lost.");
+                    WiFi.disconnect();
+                    retry_at = now; // Reconnect right away, backoff starts on failure
+                    set_net_status(NET_STATUS_OFFLINE);
+                    break;
+                }
+                if (mqtt.isConnected() || (int32_t)(now - mqtt_retry_at) >= 0) {
+                    mqtt.loop(); // Also performs the (blocking) broker connect when due
+                    if (mqtt.isConnected()) {
+                        mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+                        set_net_status(NET_STATUS_ONLINE);
+                        flush_publish_slots(now);
+                        publish_boot_trace();
+                        publish_ble_stats(now);
+                        publish_telemetry(now);
+                        publish_shot_session();
+                    } else {
+                        if (net_status == NET_STATUS_ONLINE) {
+                            mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS; // Fresh drop, first retry soon
+                        }
+                        mqtt_retry_at = now + mqtt_backoff_ms;
+                        mqtt_backoff_ms = min<uint32_t>(mqtt_backoff_ms * 2, MQTT_BACKOFF_MAX_MS);
+                        set_net_status(NET_STATUS_MQTT_CONNECTING);
+                    }
+                }
+                break;
+        }
+
+        // Fixed cadence; a blocking broker connect just skips the missed slots
+        if (!xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(HA_NETWORK_POLL_MS))) {
+            last_wake = xTaskGetTickCount();
+        }
+    }
 }
 
 // --- Initialization and Loop ---
 
+// Configures the HA device and entities and starts the network task. Never blocks.
 void ha_init() {
-    Serial.println("Connecting to WiFi...");
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
-        Serial.print(".");
+    for (int i = 0; i < HA_PUB_COUNT; i++) {
+        publish_slots[i] = {0, NAN, 0, false, false, false};
     }
-    Serial.println("\nWiFi connected.");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
+
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false); // Reconnects are paced by the network task
 
     // Set device info (optional)
     device.setName("Linea Micra Controller");
@@ -173,47 +486,90 @@ void ha_init() {
     lastShotDuration.setStep(0.1);
     lastShotDuration.onCommand(onLastShotUpdate); // Use onCommand to receive updates
 
+    bootTrace.setName("Boot Timeline");
+    bootTrace.setIcon("mdi:timer-cog-outline");
+    bootSyncTime.setName("Boot Time To Sync");
+    bootSyncTime.setIcon("mdi:timer-check-outline");
+    bootSyncTime.setUnitOfMeasurement("ms");
+    bleLatency.setName("BLE Latency");
+    bleLatency.setIcon("mdi:bluetooth-settings");
+    bleEndToEndP95.setName("BLE Write To Verified p95");
+    bleEndToEndP95.setIcon("mdi:timer-sync-outline");
+    bleEndToEndP95.setUnitOfMeasurement("ms");
+    bleRssi.setName("BLE RSSI");
+    bleRssi.setDeviceClass("signal_strength");
+    bleRssi.setUnitOfMeasurement("dBm");
+    bleFailures.setName("BLE Failures");
+    bleFailures.setIcon("mdi:bluetooth-off");
+    heapInternalFree.setName("Heap Internal Free");
+    heapInternalFree.setIcon("mdi:memory");
+    heapInternalFree.setUnitOfMeasurement("B");
+    heapInternalLargest.setName("Heap Internal Largest Block");
+    heapInternalLargest.setIcon("mdi:memory");
+    heapInternalLargest.setUnitOfMeasurement("B");
+    heapPsramFree.setName("Heap PSRAM Free");
+    heapPsramFree.setIcon("mdi:memory");
+    heapPsramFree.setUnitOfMeasurement("B");
+    lvglMemUsed.setName("LVGL Memory Used");
+    lvglMemUsed.setIcon("mdi:chart-donut");
+    lvglMemUsed.setUnitOfMeasurement("%");
+    stackHeadroom.setName("Stack Headroom");
+    stackHeadroom.setIcon("mdi:layers-triple-outline");
+    memMinima.setName("Memory Minimum Ever");
+    memMinima.setIcon("mdi:arrow-collapse-down");
+    shotSession.setName("Last Shot Session");
+    shotSession.setIcon("mdi:coffee");
+
+
+    mqtt.onConnected(onMqttConnected);
+    mqtt.onDisconnected(onMqttDisconnected);
+    mqtt.begin(mqtt_server, mqtt_user, mqtt_password); // Only stores config; connect happens in mqtt.loop()
+
+    app_events_post_int(APP_EVT_NET_STATUS, net_status);
+    if (xTaskCreatePinnedToCore(ha_network_task, "HA_Network", HA_TASK_STACK, NULL, HA_TASK_PRIORITY, &networkTaskHandle, HA_TASK_CORE) != pdPASS) {
+        LOG_E("Failed to create HA network task!");
+        networkTaskHandle = NULL;
+    }
 
-    Serial.println("Connecting to MQTT broker...");
-    mqtt.begin(mqtt_server, mqtt_user, mqtt_password);
-
-    Serial.println("HA Init Complete.");
+    LOG_I("HA Init Complete. WiFi/MQTT connecting in background.");
 }
 
-void ha_loop() {
-    mqtt.loop();
+net_status_t ha_get_net_status() {
+    return net_status;
 }
 
 // --- Functions to Send Updates TO Home Assistant ---
 
+// These only update the publish slots; the network task does the actual publish.
+
 void ha_set_machine_power(bool state) {
-    machinePower.setState(state);
+    queue_publish(HA_PUB_POWER, state, true);
 }
 
 void ha_set_preinfusion_mode(int8_t index) {
      if (index >= 0 && index < 3) {
-        preinfusionMode.setCurrentState(index);
+        queue_publish(HA_PUB_MODE, index, false);
      }
 }
 
 void ha_set_target_temperature(float temp) {
-    targetTemperature.setState(temp);
+    queue_publish(HA_PUB_TEMPERATURE, temp, false);
 }
 
 void ha_set_steam_power(int8_t power) {
     if (power >= 1 && power <= 3) {
-        // Corrected: Explicitly cast to int8_t
-        steamPower.setState((int8_t)power);
+        queue_publish(HA_PUB_STEAM_POWER, power, false);
     }
 }
 
 void ha_set_preinfusion_time(float time) {
-    preinfusionTime.setState(time);
+    queue_publish(HA_PUB_PREINFUSION_TIME, time, false);
 }
 
 void ha_trigger_backflush() {
-    // Turn the switch ON, HA automation will trigger and turn it OFF
-    backflushSwitch.setState(true);
+    // Turn the switch ON, HA automation will trigger and turn it OFF.
+    // Forced so a repeated trigger is sent even if HA never reported OFF.
+    queue_publish(HA_PUB_BACKFLUSH, 1, true, true);
 }
 
 // Function to update HA with current values (e.g., on boot or reconnect)
@@ -230,6 +586,7 @@ void ha_publish_initial_states() {
     
     // lastShotDuration is updated by HA, no need to publish initial state here
     backflushSwitch.setState(false); // Ensure backflush switch is initially off
-    Serial.println("Initial HA states published (except those needing read-back).");
+    note_remote_state(HA_PUB_BACKFLUSH, 0);
+    LOG_I("Initial HA states published (except those needing read-back).");
 }
 
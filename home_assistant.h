@@ -1,22 +1,23 @@
 /*
  * Header for the Home Assistant integration module.
  *
- * This file declares the functions for initializing the HA connection
- * and for sending commands from the UI to Home Assistant. It also
- * declares the HA entity objects as extern so they can be accessed
- * from other parts of the application. The backflush button has been
- * correctly implemented as a switch.
+ * Declares the functions for initializing the HA connection and for sending
+ * commands from the UI to Home Assistant, and the HA entity objects (extern)
+ * for the rest of the application; backflush is a switch. ha_init is
+ * non-blocking: Wi-Fi/MQTT come up on a background task.
  */
 #ifndef HOME_ASSISTANT_H
 #define HOME_ASSISTANT_H
 
 #include <ArduinoHA.h>
 #include <cstdint>
+#include "app_events.h"
 
-// Function to initialize the Home Assistant connection
+// Function to initialize the Home Assistant connection (returns immediately)
 void ha_init();
+net_status_t ha_get_net_status();
 
-// --- Functions to send commands from UI to HA ---
+// --- Functions to send commands from UI to HA (debounced, published by the network task) ---
 void ha_set_machine_power(bool state);
 void ha_set_preinfusion_mode(int8_t mode_index);
 void ha_set_target_temperature(float temp);
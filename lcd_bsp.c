@@ -1,13 +1,31 @@
 /*
  * Waveshare ESP32-S3-Knob-Touch-LCD-1.8 Board Support Package for the LCD.
  *
- * Updated for LVGL v9 API.
- * Creates a dedicated FreeRTOS task to handle all LVGL UI updates.
- * Display rotation reverted to default orientation.
- * Touch coordinate transformation RE-ADDED to counteract persistent mirroring from the touch controller.
- * Increased LVGL task stack size.
- * Color format line commented out as LV_COLOR_16_SWAP is used in lv_conf.h.
- * Calls reset_inactivity_timer() on touch.
+ * Brings up the SH8601 QSPI panel, the CST816 touch controller and LVGL v9,
+ * and runs all LVGL work on a dedicated task pinned to the UI core
+ * (task_config.h). Each cycle applies the event bus posts (app_events.h) and
+ * then runs lv_timer_handler().
+ *
+ * Flush completion is signalled from the QSPI DMA trans-done callback, so
+ * LVGL renders the next band while the current one is still on the bus.
+ * Draw buffer placement and render mode are selected by LCD_RENDER_MODE;
+ * the color byte order comes from LV_COLOR_16_SWAP in lv_conf.h. Touch
+ * coordinates are rotated to counteract the controller's mirroring, and a
+ * touch calls reset_inactivity_timer().
+ *
+ * Touch is event-driven when the CST816 INT line is configured: the INT ISR
+ * wakes the LVGL task, which reads the controller only on touch reports and
+ * while a finger is down, so an idle screen generates no I2C traffic.
+ * Otherwise the controller is polled.
+ *
+ * Display power: when the backlight goes off the panel is put to sleep, the
+ * 2 ms LVGL tick is stopped and the LVGL task only wakes every
+ * LCD_SLEEP_SERVICE_MS (or on encoder/touch), so DFS and light sleep can engage.
+ *
+ * LCD_RENDER_STATS is a render benchmark mode: per-frame render time, flush
+ * bytes and count, flush-wait and lv_timer_handler() time and the invalidated
+ * area after rounding, with an optional FPS/CPU overlay (LCD_RENDER_OVERLAY)
+ * and a scripted swipe/label-update loop (LCD_RENDER_BENCH).
  */
 
 #include "lcd_bsp.h"
@@ -16,6 +34,12 @@
 #include "cst816.h"
 #include "lvgl_display.h" // Include our custom display header
 #include "lcd_bl_pwm_bsp.h" // Include backlight functions
+#include "task_config.h"
+#include "boot_trace.h"
+#include "app_log.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 
 static SemaphoreHandle_t lvgl_mux = NULL;
 #define LCD_HOST SPI2_HOST
@@ -23,6 +47,76 @@ static SemaphoreHandle_t lvgl_mux = NULL;
 static esp_lcd_panel_io_handle_t amoled_panel_io_handle = NULL;
 static lv_display_t *disp = NULL; // Global display handle for v9
 
+// Flush handshake between the flush callback and the color trans-done ISR
+static SemaphoreHandle_t flush_done_sem = NULL;
+static volatile bool flush_in_flight = false;
+#define FLUSH_WAIT_TIMEOUT_MS 100 // Safety net if a trans-done event is ever lost
+
+// Event-driven touch: the INT ISR flags a report and wakes the LVGL task
+static TaskHandle_t lvgl_task_handle = NULL;
+static lv_indev_t *touch_indev = NULL;
+static volatile bool touch_irq_pending = false;
+static bool touch_pressed = false; // Keep reading until the release is seen
+
+// Display power state: ON -> SLEEP_PENDING (requested from LVGL context) -> ASLEEP -> ON
+typedef enum {
+    DISPLAY_POWER_ON,
+    DISPLAY_POWER_SLEEP_PENDING,
+    DISPLAY_POWER_ASLEEP,
+} display_power_t;
+static volatile display_power_t display_power = DISPLAY_POWER_ON;
+static volatile bool display_wake_requested = false;
+static esp_timer_handle_t lvgl_tick_timer = NULL;
+static int64_t lvgl_tick_stopped_us = 0; // Time LVGL's clock has been advanced to while the tick is stopped
+#if LCD_PM_ENABLE && CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t display_pm_lock = NULL; // Held while the display is on
+#endif
+
+#if LCD_RENDER_MODE == LCD_RENDER_INTERNAL_BANDS
+#define LVGL_BUF_CAPS (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+#else
+#define LVGL_BUF_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#endif
+
+#if LCD_RENDER_STATS
+#define RENDER_STATS_PERIOD_MS 5000
+#define RENDER_OVERLAY_PERIOD_MS 1000
+#define RENDER_BENCH_STEP_MS 50        // Weight label update interval
+#define RENDER_BENCH_SWIPE_STEPS 40    // Label updates between two screen swipes
+#define RENDER_BENCH_ANIM_MS 300       // Same as the swipe in lvgl_display.cpp
+
+// Counted on the LVGL task only (flush, rounder and refresh callbacks run inside
+// lv_timer_handler()), so no locking. Sums run from boot; each report takes the
+// difference to its own previous copy. Maxima are reset by the 5 s report.
+typedef struct {
+    uint32_t frames;         // Refreshes that flushed something
+    uint32_t flushes;
+    uint64_t flush_bytes;
+    uint64_t flush_wait_us;  // LVGL task blocked on the DMA in the flush-wait callback
+    uint64_t render_us;      // REFR_START -> REFR_READY of frames that flushed
+    uint32_t render_max_us;
+    uint32_t cycles;         // lv_timer_handler() calls
+    uint64_t handler_us;
+    uint32_t handler_max_us;
+    uint32_t areas;          // Invalidated areas, after the rounder
+    uint64_t area_px;
+    uint32_t area_max_px;
+} render_stats_t;
+
+static render_stats_t render_stats;
+static int64_t refr_start_us = 0;
+static uint32_t refr_start_flushes = 0;
+static void render_stats_timer_cb(lv_timer_t *timer);
+static void render_refr_event_cb(lv_event_t *e);
+#if LCD_RENDER_OVERLAY
+static lv_obj_t *render_overlay_label = NULL;
+static void render_overlay_timer_cb(lv_timer_t *timer);
+#endif
+#if LCD_RENDER_BENCH
+static void render_bench_timer_cb(lv_timer_t *timer);
+#endif
+#endif
+
 // Initialization command list (unchanged)
 static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
     // ... (Command list omitted for brevity) ...
@@ -215,8 +309,15 @@ static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
 
 // LVGL v9 function signatures
 static void example_lvgl_flush_cb(lv_display_t *display, const lv_area_t *area, uint8_t *px_map);
+static void example_lvgl_flush_wait_cb(lv_display_t *display);
+static bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
 static void example_lvgl_rounder_cb(lv_event_t * e);
 static void example_lvgl_touch_cb(lv_indev_t * indev, lv_indev_data_t * data);
+static bool example_touch_irq_cb(void *arg);
+static void display_enter_sleep(void);
+static void display_exit_sleep(void);
+static void display_sleep_loop(void);
+static void example_lvgl_events_posted(void);
 static void example_increase_lvgl_tick(void *arg);
 static void example_lvgl_port_task(void *arg);
 static void example_lvgl_unlock(void);
@@ -234,14 +335,18 @@ void lcd_lvgl_Init(void) {
                                                                  EXAMPLE_PIN_NUM_LCD_DATA1,
                                                                  EXAMPLE_PIN_NUM_LCD_DATA2,
                                                                  EXAMPLE_PIN_NUM_LCD_DATA3,
-                                                                 EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * LCD_BIT_PER_PIXEL / 8);
+                                                                 LCD_SPI_MAX_TRANSFER_SZ);
     ESP_ERROR_CHECK_WITHOUT_ABORT(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO));
     esp_lcd_panel_io_handle_t io_handle = NULL;
 
-    // In v9, the flush ready callback is not set in IO config but during display creation
+    flush_done_sem = xSemaphoreCreateBinary();
+    assert(flush_done_sem);
+
+    // Color transfer done -> lv_display_flush_ready(). The display is created later,
+    // so the context is the address of the display handle, not the handle itself.
     const esp_lcd_panel_io_spi_config_t io_config = SH8601_PANEL_IO_QSPI_CONFIG(EXAMPLE_PIN_NUM_LCD_CS,
-                                                                                NULL, // Callback removed here
-                                                                                NULL); // Context removed here
+                                                                                example_notify_lvgl_flush_ready,
+                                                                                &disp);
     sh8601_vendor_config_t vendor_config = {
         .init_cmds = lcd_init_cmds,
         .init_cmds_size = sizeof(lcd_init_cmds) / sizeof(lcd_init_cmds[0]),
@@ -267,12 +372,15 @@ void lcd_lvgl_Init(void) {
 
     lv_init();
 
-    // Allocate draw buffers
-    // Use MALLOC_CAP_DMA for direct memory access by SPI driver
-    lv_color_t *buf1 = (lv_color_t*)heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    // Allocate draw buffers (internal DMA RAM or PSRAM, see LCD_RENDER_MODE)
+    size_t internal_free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    lv_color_t *buf1 = (lv_color_t*)heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), LVGL_BUF_CAPS);
     assert(buf1);
-    lv_color_t *buf2 = (lv_color_t*)heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    lv_color_t *buf2 = (lv_color_t*)heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), LVGL_BUF_CAPS);
     assert(buf2);
+    LOG_I("LVGL render mode %d: 2 x %d lines, internal heap %u -> %u bytes free",
+          LCD_RENDER_MODE, EXAMPLE_LVGL_BUF_HEIGHT,
+          (unsigned)internal_free_before, (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
 
     // Create display in v9, passing resolution
     disp = lv_display_create(EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES);
@@ -283,12 +391,22 @@ void lcd_lvgl_Init(void) {
 
     // Set callbacks and buffer using v9 functions
     lv_display_set_flush_cb(disp, example_lvgl_flush_cb);
+    // Block the LVGL task on the DMA instead of spinning while the last band is sent
+    lv_display_set_flush_wait_cb(disp, example_lvgl_flush_wait_cb);
     // Pass allocated buffers directly
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+    lv_display_set_buffers(disp, buf1, buf2, EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), LV_DISPLAY_RENDER_MODE_DIRECT);
+#else
     lv_display_set_buffers(disp, buf1, buf2, EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), LV_DISPLAY_RENDER_MODE_PARTIAL);
+#endif
     lv_display_set_user_data(disp, panel_handle); // Associate panel handle with display
 
     // Add rounder callback using events in v9
     lv_display_add_event_cb(disp, example_lvgl_rounder_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+#if LCD_RENDER_STATS
+    lv_display_add_event_cb(disp, render_refr_event_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(disp, render_refr_event_cb, LV_EVENT_REFR_READY, NULL);
+#endif
 
 
     // Create and register the input device (touch)
@@ -297,6 +415,15 @@ void lcd_lvgl_Init(void) {
     lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(indev, example_lvgl_touch_cb);
     lv_indev_set_display(indev, disp);
+    if (Touch_IrqEnabled()) {
+        // Read only when the INT line reports a touch instead of every LVGL poll
+        lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
+        touch_indev = indev;
+        Touch_SetIrqCallback(example_touch_irq_cb, NULL);
+        LOG_I("Touch: interrupt mode on GPIO %d", EXAMPLE_PIN_NUM_TOUCH_INT);
+    } else {
+        LOG_I("Touch: INT not available, polling");
+    }
 
 
     // Tick timer setup (remains similar)
@@ -304,23 +431,149 @@ void lcd_lvgl_Init(void) {
         .callback = &example_increase_lvgl_tick,
         .name = "lvgl_tick"
     };
-    esp_timer_handle_t lvgl_tick_timer = NULL;
     ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
 
+#if LCD_PM_ENABLE && CONFIG_PM_ENABLE
+    // Let the CPU scale down and light-sleep, but only while the display is asleep
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = LCD_PM_MIN_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    if (esp_pm_configure(&pm_config) == ESP_OK &&
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "display", &display_pm_lock) == ESP_OK) {
+        esp_pm_lock_acquire(display_pm_lock);
+    } else {
+        LOG_W("Power management not available");
+    }
+#endif
+
     // LVGL task and mutex setup
     lvgl_mux = xSemaphoreCreateMutex();
     assert(lvgl_mux);
-    // Increased stack size for LVGL task
-    xTaskCreate(example_lvgl_port_task, "LVGL_UI_Task", (8 * 1024), NULL, EXAMPLE_LVGL_TASK_PRIORITY, NULL);
+    // Pinned away from the radio core so BLE/Wi-Fi bursts don't stall rendering
+    xTaskCreatePinnedToCore(example_lvgl_port_task, "LVGL_UI_Task", LVGL_TASK_STACK, NULL, LVGL_TASK_PRIORITY,
+                            &lvgl_task_handle, LVGL_TASK_CORE);
 
     // Initialize custom UI
     if (example_lvgl_lock(-1)) {
         lvgl_display_init(); // Call our custom UI builder defined in lvgl_display.cpp
+        app_events_set_listener(example_lvgl_events_posted);
+#if LCD_RENDER_STATS
+        lv_timer_create(render_stats_timer_cb, RENDER_STATS_PERIOD_MS, NULL);
+#if LCD_RENDER_OVERLAY
+        render_overlay_label = lv_label_create(lv_layer_top());
+        lv_obj_set_style_text_font(render_overlay_label, &lv_font_montserrat_16, 0);
+        lv_obj_set_style_text_color(render_overlay_label, lv_color_hex(0xFFFF00), 0);
+        lv_obj_set_style_bg_color(render_overlay_label, lv_color_hex(0x000000), 0);
+        lv_obj_set_style_bg_opa(render_overlay_label, LV_OPA_COVER, 0);
+        lv_obj_align(render_overlay_label, LV_ALIGN_BOTTOM_MID, 0, -8); // Clear of the round panel's edge
+        lv_label_set_text(render_overlay_label, "-- FPS");
+        lv_timer_create(render_overlay_timer_cb, RENDER_OVERLAY_PERIOD_MS, NULL);
+#endif
+#if LCD_RENDER_BENCH
+        lv_timer_create(render_bench_timer_cb, RENDER_BENCH_STEP_MS, NULL);
+        LOG_I("Render benchmark running");
+#endif
+#endif
         example_lvgl_unlock();
     }
 }
 
+#if LCD_RENDER_STATS
+// Refresh start/end, to time each frame from the first redraw to the last flush
+static void render_refr_event_cb(lv_event_t *e) {
+    int64_t now = esp_timer_get_time();
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+        refr_start_us = now;
+        refr_start_flushes = render_stats.flushes;
+    } else if (render_stats.flushes != refr_start_flushes) {
+        uint32_t us = (uint32_t)(now - refr_start_us);
+        render_stats.render_us += us;
+        if (us > render_stats.render_max_us) render_stats.render_max_us = us;
+    }
+}
+
+// Logs the last RENDER_STATS_PERIOD_MS: frame rate and timing, bus traffic, how much
+// of the screen was invalidated, and internal heap headroom for the active render mode
+static void render_stats_timer_cb(lv_timer_t *timer) {
+    static render_stats_t prev;
+    render_stats_t d = render_stats;
+    d.frames -= prev.frames;
+    d.flushes -= prev.flushes;
+    d.flush_bytes -= prev.flush_bytes;
+    d.flush_wait_us -= prev.flush_wait_us;
+    d.render_us -= prev.render_us;
+    d.cycles -= prev.cycles;
+    d.handler_us -= prev.handler_us;
+    d.areas -= prev.areas;
+    d.area_px -= prev.area_px;
+    prev = render_stats;
+    render_stats.render_max_us = 0;
+    render_stats.handler_max_us = 0;
+    render_stats.area_max_px = 0;
+    if (d.frames == 0) return; // Idle screen, nothing to report
+
+    LOG_I("Render mode %d: %.1f FPS, %.1f flushes and %.1f KB per frame, internal free %u (min %u, largest %u)",
+          LCD_RENDER_MODE,
+          d.frames * 1000.0f / RENDER_STATS_PERIOD_MS, (float)d.flushes / d.frames,
+          d.flush_bytes / 1024.0f / d.frames,
+          (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+          (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+          (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    LOG_I("  frame %.2f ms (max %.2f), flush wait %.2f ms/frame, lv_timer_handler %.2f ms (max %.2f, %.0f%% CPU), "
+          "%.1f areas/frame, %lu px avg, %lu px max",
+          d.render_us / 1000.0f / d.frames, d.render_max_us / 1000.0f,
+          d.flush_wait_us / 1000.0f / d.frames,
+          d.cycles ? d.handler_us / 1000.0f / d.cycles : 0.0f, d.handler_max_us / 1000.0f,
+          d.handler_us / 10.0f / RENDER_STATS_PERIOD_MS,
+          (float)d.areas / d.frames, d.areas ? (unsigned long)(d.area_px / d.areas) : 0UL,
+          (unsigned long)d.area_max_px);
+}
+
+#if LCD_RENDER_OVERLAY
+// FPS and the share of time spent in lv_timer_handler() over the last second.
+// Updating the label costs a small redraw of its own, which is counted too.
+static void render_overlay_timer_cb(lv_timer_t *timer) {
+    static uint32_t prev_frames = 0;
+    static uint64_t prev_handler_us = 0, prev_render_us = 0;
+    uint32_t frames = render_stats.frames - prev_frames;
+    uint64_t handler_us = render_stats.handler_us - prev_handler_us;
+    uint64_t render_us = render_stats.render_us - prev_render_us;
+    prev_frames = render_stats.frames;
+    prev_handler_us = render_stats.handler_us;
+    prev_render_us = render_stats.render_us;
+    lv_label_set_text_fmt(render_overlay_label, "%lu FPS  %lu%% CPU  %lu.%lu ms",
+                          (unsigned long)(frames * 1000 / RENDER_OVERLAY_PERIOD_MS),
+                          (unsigned long)(handler_us / 10 / RENDER_OVERLAY_PERIOD_MS),
+                          (unsigned long)(frames ? render_us / frames / 1000 : 0),
+                          (unsigned long)(frames ? render_us / frames / 100 % 10 : 0));
+}
+#endif
+
+#if LCD_RENDER_BENCH
+// Scripted load: changes the weight label every step and swipes between the
+// two screens every RENDER_BENCH_SWIPE_STEPS steps, forever. Only the label
+// changes, not target_weight, so nothing is written to the stopper.
+static void render_bench_timer_cb(lv_timer_t *timer) {
+    static uint32_t step = 0;
+    step++;
+    reset_inactivity_timer(); // Keep the display on
+    update_display_value((int8_t)(20 + step % 40));
+    if (step % RENDER_BENCH_SWIPE_STEPS == 0 && screen_ha) { // screen_ha is NULL until the prebuild
+        if (lv_screen_active() == screen_ha) {
+            lv_screen_load_anim(screen_shot_stopper, LV_SCR_LOAD_ANIM_MOVE_BOTTOM, RENDER_BENCH_ANIM_MS, 0, false);
+        } else {
+            lv_screen_load_anim(screen_ha, LV_SCR_LOAD_ANIM_MOVE_TOP, RENDER_BENCH_ANIM_MS, 0, false);
+        }
+    }
+}
+#endif
+#endif
+
 static bool example_lvgl_lock(int timeout_ms) {
     const TickType_t timeout_ticks = (timeout_ms == -1) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
     return xSemaphoreTake(lvgl_mux, timeout_ticks) == pdTRUE;
@@ -334,9 +587,26 @@ static void example_lvgl_unlock(void) {
 static void example_lvgl_port_task(void *arg) {
     uint32_t task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
     while (1) {
+        if (display_power != DISPLAY_POWER_ON) {
+            display_sleep_loop(); // Returns once the display is back on
+        }
         // Lock the mutex while calling lv_timer_handler()
         if (example_lvgl_lock(-1)) {
+            if (touch_indev && (touch_irq_pending || touch_pressed)) {
+                touch_irq_pending = false;
+                lv_indev_read(touch_indev);
+            }
+            lvgl_display_process_events(); // Everything posted since the last cycle, in one pass
+#if LCD_RENDER_STATS
+            int64_t handler_start = esp_timer_get_time();
+#endif
             task_delay_ms = lv_timer_handler();
+#if LCD_RENDER_STATS
+            uint32_t handler_us = (uint32_t)(esp_timer_get_time() - handler_start);
+            render_stats.cycles++;
+            render_stats.handler_us += handler_us;
+            if (handler_us > render_stats.handler_max_us) render_stats.handler_max_us = handler_us;
+#endif
             example_lvgl_unlock();
         }
         if (task_delay_ms > EXAMPLE_LVGL_TASK_MAX_DELAY_MS) {
@@ -344,10 +614,124 @@ static void example_lvgl_port_task(void *arg) {
         } else if (task_delay_ms < EXAMPLE_LVGL_TASK_MIN_DELAY_MS) {
             task_delay_ms = EXAMPLE_LVGL_TASK_MIN_DELAY_MS;
         }
-        vTaskDelay(pdMS_TO_TICKS(task_delay_ms));
+        if (touch_pressed && task_delay_ms > EXAMPLE_TOUCH_POLL_MS) {
+            task_delay_ms = EXAMPLE_TOUCH_POLL_MS; // Track drags and the release
+        }
+        // Sleep until LVGL's next timer is due or a touch report wakes us early
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(task_delay_ms));
+    }
+}
+
+void lcd_display_sleep(void) {
+    if (display_power == DISPLAY_POWER_ON) {
+        display_power = DISPLAY_POWER_SLEEP_PENDING; // Acted on by the LVGL task after this cycle
     }
 }
 
+void lcd_display_wake(void) {
+    if (display_power == DISPLAY_POWER_ON) return;
+    display_wake_requested = true;
+    if (lvgl_task_handle) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
+
+bool lcd_display_is_awake(void) {
+    return display_power == DISPLAY_POWER_ON;
+}
+
+// Advances LVGL's clock by the time elapsed since the tick timer was stopped
+static void lvgl_tick_catch_up(void) {
+    int64_t elapsed_ms = (esp_timer_get_time() - lvgl_tick_stopped_us) / 1000;
+    lv_tick_inc((uint32_t)elapsed_ms);
+    lvgl_tick_stopped_us += elapsed_ms * 1000;
+}
+
+// LVGL task, lock held
+static void display_enter_sleep(void) {
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)lv_display_get_user_data(disp);
+
+    // Nothing is visible, so don't render until we wake
+    lv_display_enable_invalidation(disp, false);
+    esp_timer_stop(lvgl_tick_timer);
+    lvgl_tick_stopped_us = esp_timer_get_time();
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_lcd_panel_disp_on_off(panel_handle, false));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_lcd_panel_disp_sleep(panel_handle, true));
+    display_power = DISPLAY_POWER_ASLEEP;
+#if LCD_PM_ENABLE && CONFIG_PM_ENABLE
+    if (display_pm_lock) esp_pm_lock_release(display_pm_lock);
+#endif
+    LOG_I("Display asleep");
+}
+
+// LVGL task, lock held
+static void display_exit_sleep(void) {
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)lv_display_get_user_data(disp);
+
+#if LCD_PM_ENABLE && CONFIG_PM_ENABLE
+    if (display_pm_lock) esp_pm_lock_acquire(display_pm_lock);
+#endif
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_lcd_panel_disp_sleep(panel_handle, false));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_lcd_panel_disp_on_off(panel_handle, true));
+    lvgl_tick_catch_up();
+    esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000);
+    // Redraw everything that changed while invalidation was off
+    lv_display_enable_invalidation(disp, true);
+    lv_obj_invalidate(lv_screen_active());
+    display_wake_requested = false;
+    display_power = DISPLAY_POWER_ON;
+    LOG_I("Display awake");
+}
+
+// Parks the LVGL task while the display is asleep. LVGL timers, event bus posts and
+// polled touch are still serviced every LCD_SLEEP_SERVICE_MS with the clock caught up
+// in one step; an encoder turn or touch report ends the loop early.
+static void display_sleep_loop(void) {
+    if (example_lvgl_lock(-1)) {
+        if (display_wake_requested) {
+            // Activity arrived before we got here; cancel the request
+            display_wake_requested = false;
+            display_power = DISPLAY_POWER_ON;
+            example_lvgl_unlock();
+            return;
+        }
+        display_enter_sleep();
+        example_lvgl_unlock();
+    }
+    while (!display_wake_requested && !touch_irq_pending) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LCD_SLEEP_SERVICE_MS));
+        if (display_wake_requested || touch_irq_pending) break;
+        if (example_lvgl_lock(-1)) {
+            lvgl_tick_catch_up();
+            lvgl_display_process_events(); // Keeps widget state current while dark
+            lv_timer_handler(); // May call lcd_display_wake() via reset_inactivity_timer()
+            example_lvgl_unlock();
+        }
+    }
+    if (example_lvgl_lock(-1)) {
+        display_exit_sleep();
+        example_lvgl_unlock();
+    }
+}
+
+// Event bus listener. While asleep, posts wait for the next service cycle
+// instead of waking the CPU; nothing is drawn until the display is back on.
+static void example_lvgl_events_posted(void) {
+    if (display_power == DISPLAY_POWER_ON && lvgl_task_handle) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
+
+// Runs in the CST816 INT ISR
+static bool IRAM_ATTR example_touch_irq_cb(void *arg) {
+    BaseType_t woken = pdFALSE;
+    touch_irq_pending = true;
+    if (lvgl_task_handle) {
+        vTaskNotifyGiveFromISR(lvgl_task_handle, &woken);
+    }
+    return woken == pdTRUE;
+}
+
 static void example_increase_lvgl_tick(void *arg) {
     lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
 }
@@ -361,11 +745,60 @@ static void example_lvgl_flush_cb(lv_display_t *display, const lv_area_t *area,
     int offsety1 = area->y1;
     int offsety2 = area->y2;
 
-    // Pass the draw buffer directly to the panel driver
-    esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, px_map);
+    // Pass the draw buffer directly to the panel driver. The transfer is queued on the
+    // SPI DMA; lv_display_flush_ready() is called from the trans-done callback, so the
+    // buffer stays owned by the driver until it has actually been sent.
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+    // px_map is the whole frame; the rounder made the area full-width, so its rows are contiguous
+    px_map += offsety1 * EXAMPLE_LCD_H_RES * (LCD_BIT_PER_PIXEL / 8);
+#endif
+#if LCD_RENDER_STATS
+    render_stats.flushes++;
+    render_stats.flush_bytes += (uint32_t)(offsetx2 - offsetx1 + 1) * (offsety2 - offsety1 + 1) * (LCD_BIT_PER_PIXEL / 8);
+    if (lv_display_flush_is_last(display)) render_stats.frames++;
+#endif
+    // Last band of a frame: flushing_last is still set here, unlike after the DMA
+    // completes (lv_display_flush_ready() clears it). No-op after the first frame.
+    if (lv_display_flush_is_last(display)) {
+        boot_trace_mark(BOOT_MARK_FIRST_FRAME);
+    }
 
-    // Indicate flushing is ready (moved from separate callback)
-    lv_display_flush_ready(display);
+    flush_in_flight = true;
+    if (esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, px_map) != ESP_OK) {
+        // Nothing was queued, so no trans-done event will follow
+        flush_in_flight = false;
+        lv_display_flush_ready(display);
+    }
+}
+
+// Called in ISR context when the panel IO has finished sending a color buffer
+static bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx) {
+    lv_display_t *display = *(lv_display_t **)user_ctx;
+    BaseType_t high_task_awoken = pdFALSE;
+
+    if (display && flush_in_flight) {
+        flush_in_flight = false;
+        lv_display_flush_ready(display);
+        xSemaphoreGiveFromISR(flush_done_sem, &high_task_awoken);
+    }
+    return high_task_awoken == pdTRUE;
+}
+
+// Called by LVGL when it needs the previous flush to finish before reusing a buffer
+static void example_lvgl_flush_wait_cb(lv_display_t *display) {
+#if LCD_RENDER_STATS
+    int64_t wait_start = esp_timer_get_time();
+#endif
+    while (flush_in_flight) {
+        if (xSemaphoreTake(flush_done_sem, pdMS_TO_TICKS(FLUSH_WAIT_TIMEOUT_MS)) != pdTRUE && flush_in_flight) {
+            // Should not happen; release the buffer rather than hang the UI
+            flush_in_flight = false;
+            lv_display_flush_ready(display);
+        }
+    }
+#if LCD_RENDER_STATS
+    render_stats.flush_wait_us += esp_timer_get_time() - wait_start;
+#endif
 }
 
 // LVGL v9 rounder callback signature (using event system)
@@ -378,6 +811,18 @@ static void example_lvgl_rounder_cb(lv_event_t * e) {
     area->y1 = area->y1 & ~1;
     area->x2 = (area->x2 & ~1) + 1; // Round down then add 1 to ensure width includes the last pixel
     area->y2 = (area->y2 & ~1) + 1; // Round down then add 1 to ensure height includes the last pixel
+
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+    // Send whole rows so the dirty region is one contiguous slice of the frame buffer
+    area->x1 = 0;
+    area->x2 = EXAMPLE_LCD_H_RES - 1;
+#endif
+#if LCD_RENDER_STATS
+    uint32_t px = (uint32_t)lv_area_get_size(area);
+    render_stats.areas++;
+    render_stats.area_px += px;
+    if (px > render_stats.area_max_px) render_stats.area_max_px = px;
+#endif
 }
 
 
@@ -403,5 +848,6 @@ static void example_lvgl_touch_cb(lv_indev_t * indev, lv_indev_data_t * data) {
     } else {
         data->state = LV_INDEV_STATE_RELEASED;
     }
+    touch_pressed = touched;
 }
 
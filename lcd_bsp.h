@@ -28,6 +28,13 @@ static void example_lvgl_port_task(void *arg);
 static void example_lvgl_unlock(void);
 static bool example_lvgl_lock(int timeout_ms);
 void lcd_lvgl_Init(void);
+
+// Display power state machine. lcd_display_sleep() must be called from LVGL context;
+// it blanks the panel, stops the LVGL tick and parks the LVGL task after the current cycle.
+// lcd_display_wake() is safe from any task; touch reports wake the display on their own.
+void lcd_display_sleep(void);
+void lcd_display_wake(void);
+bool lcd_display_is_awake(void);
 static void example_lvgl_touch_cb(lv_indev_t * indev, lv_indev_data_t * data);
 
 #ifdef __cplusplus
@@ -15,16 +15,57 @@
 #define EXAMPLE_PIN_NUM_LCD_RST     21
 #define EXAMPLE_PIN_NUM_BK_LIGHT    47
 
+// Render configuration (pick per hardware revision, measure with LCD_RENDER_STATS)
+//   LCD_RENDER_INTERNAL_BANDS: 2 x 36-line bands in internal DMA RAM, PARTIAL mode (~51 KB internal)
+//   LCD_RENDER_PSRAM_BANDS:    2 x 120-line bands in PSRAM, PARTIAL mode (fewer flushes per frame)
+//   LCD_RENDER_PSRAM_DIRECT:   2 x full frames in PSRAM, DIRECT mode, only dirty rows are sent
+#define LCD_RENDER_INTERNAL_BANDS      0
+#define LCD_RENDER_PSRAM_BANDS         1
+#define LCD_RENDER_PSRAM_DIRECT        2
+#ifndef LCD_RENDER_MODE
+#define LCD_RENDER_MODE                LCD_RENDER_INTERNAL_BANDS
+#endif
+
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+#define EXAMPLE_LVGL_BUF_HEIGHT        EXAMPLE_LCD_V_RES
+#elif LCD_RENDER_MODE == LCD_RENDER_PSRAM_BANDS
+#define EXAMPLE_LVGL_BUF_HEIGHT        (EXAMPLE_LCD_V_RES / 3)
+#else
 #define EXAMPLE_LVGL_BUF_HEIGHT        (EXAMPLE_LCD_V_RES / 10)
+#endif
+
+// PSRAM buffers go through internal DMA bounce buffers; keep each SPI transfer small
+#if LCD_RENDER_MODE == LCD_RENDER_INTERNAL_BANDS
+#define LCD_SPI_MAX_TRANSFER_SZ        (EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * LCD_BIT_PER_PIXEL / 8)
+#else
+#define LCD_SPI_MAX_TRANSFER_SZ        (EXAMPLE_LCD_H_RES * 20 * LCD_BIT_PER_PIXEL / 8)
+#endif
+
+// Render benchmark mode (debug builds; LCD_RENDER_OVERLAY and LCD_RENDER_BENCH need LCD_RENDER_STATS)
+#ifndef LCD_RENDER_STATS
+#define LCD_RENDER_STATS               0                          //1 = log FPS, flush, timer handler and invalidation stats every 5 s
+#endif
+#ifndef LCD_RENDER_OVERLAY
+#define LCD_RENDER_OVERLAY             0                          //1 = draw FPS and LVGL task CPU on the top layer, updated every second
+#endif
+#ifndef LCD_RENDER_BENCH
+#define LCD_RENDER_BENCH               0                          //1 = loop the swipe animation and weight label updates from boot
+#endif
 #define EXAMPLE_LVGL_TICK_PERIOD_MS    2                          //Timer time
 #define EXAMPLE_LVGL_TASK_MAX_DELAY_MS 500                        //LVGL Indicates the maximum time for a task to run
 #define EXAMPLE_LVGL_TASK_MIN_DELAY_MS 1                          //LVGL Minimum time to run a task
-#define EXAMPLE_LVGL_TASK_STACK_SIZE   (4 * 1024)                 //LVGL runs the task stack
-#define EXAMPLE_LVGL_TASK_PRIORITY     2                          //LVGL Running task priority
+// LVGL task core, priority and stack are in task_config.h
+#define LCD_SLEEP_SERVICE_MS           1000                       //LVGL timer service interval while the display is asleep
+#define LCD_PM_ENABLE                  1                          //1 = DFS/light sleep while the display is asleep (needs CONFIG_PM_ENABLE)
+#define LCD_PM_MIN_FREQ_MHZ            80                         //CPU floor for DFS
 
 #define EXAMPLE_TOUCH_ADDR                0x15
 #define EXAMPLE_PIN_NUM_TOUCH_SCL 12
 #define EXAMPLE_PIN_NUM_TOUCH_SDA 11
+#ifndef EXAMPLE_PIN_NUM_TOUCH_INT
+#define EXAMPLE_PIN_NUM_TOUCH_INT -1      //CST816 INT (active low, GPIO 9 on boards that wire it); -1 = poll the touch controller
+#endif
+#define EXAMPLE_TOUCH_POLL_MS     10      //Read interval while a finger is down in interrupt mode
 
 
 //#define Backlight_Testing
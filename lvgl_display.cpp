@@ -1,13 +1,26 @@
 /*
  * LVGL display implementation for the shotStopper controller.
  *
- * Added battery percentage indicator to the Shot Stopper screen,
- * updated periodically via an LVGL timer.
- * Added inactivity timer for screen dimming and backlight off.
- * Implemented moving average filter for battery readings to stabilize percentage.
- * Preset buttons now use the debounce timer before triggering BLE write.
- * 
- * Converted to XML-based UI loading for LVGL Online Editor compatibility.
+ * Screens are built from precompiled op streams (ui/ui_screen_ops.h), with
+ * the runtime XML parser as a fallback. The HA screen is built lazily (first
+ * swipe up or an idle prebuild shortly after boot); HA updates received before
+ * that are cached and applied then.
+ *
+ * Everything here runs on the LVGL task. BLE, HA and the battery sampler post
+ * to the event bus and lvgl_display_process_events() applies the result once
+ * per cycle. Value labels go through cached_label_set_fmt(), so unchanged text
+ * (repeated HA states, an unchanged battery level) doesn't re-lay out or redraw.
+ *
+ * Knob turns are applied in batches from an LVGL timer (encoder_ui_poll).
+ * Preset taps are discrete: touching a preset already starts the BLE connect
+ * (ble_prepare_write), and the tap cancels the knob debounce and writes at
+ * once. Presets live in the settings store (settings.h), so a long-press
+ * never writes flash on the LVGL task.
+ *
+ * An inactivity timer dims the backlight and then turns it off, which also
+ * puts the panel to sleep (lcd_display_sleep); activity wakes it. The LVGL
+ * heap is sampled for telemetry, including right after a screen is built.
+ * Logs go through app_log so the LVGL task never blocks on the UART.
  */
 #include "lvgl_display.h"
 #include "ble_client.h"
@@ -15,12 +28,22 @@
 #include "app_events.h"
 #include "home_assistant.h"
 #include "lcd_bl_pwm_bsp.h" // Include backlight functions
+#include "lcd_bsp.h" // Display sleep/wake
+#include "telemetry.h"
+#include "app_log.h"
+#include "settings.h"
 #include "lvgl_xml_loader.h"
+#if LVGL_UI_USE_COMPILED
+#include "ui/ui_screen_ops.h"
+#else
 #include "ui/ui_xml_strings.h"
+#endif
 #include <lvgl.h>
 #include <cstdio>
-#include <Arduino.h> // Required for analogReadMilliVolts, FreeRTOS timers
-#include <Preferences.h> // Needed for preset saving/loading
+#include <cstdarg>
+#include <cstring>
+#include <Arduino.h> // Required for FreeRTOS timers
+#include <esp_timer.h> // For screen build timing
 
 // --- Brightness / Inactivity ---
 #define INACTIVITY_TIMEOUT_DIM_MS 30000 // 30 seconds to dim
@@ -32,21 +55,16 @@
 static lv_timer_t* inactivity_timer = NULL;
 static uint8_t current_brightness_level = BRIGHTNESS_HIGH; // Track current level
 
-// --- Battery Monitoring ---
-#define BATTERY_ADC_PIN 1   // GPIO1 for battery voltage divider
-#define BATTERY_MAX_MV 4200 // Max voltage (4.2V) in millivolts
-#define BATTERY_MIN_MV 3000 // Min voltage (3.0V) in millivolts (conservative)
-#define BATTERY_READING_COUNT 5 // Number of readings to average
-
-static uint32_t battery_readings[BATTERY_READING_COUNT];
-static int battery_reading_index = 0;
-static uint32_t battery_reading_sum = 0;
-static bool battery_filter_initialized = false;
+// --- Encoder ---
+#define ENCODER_UI_POLL_MS 20 // Accumulated knob turns are applied at most this often
+#define TELEMETRY_LVGL_SAMPLE_MS 2000 // LVGL heap sampling for the telemetry collector
+#define HA_DETENTS_PER_STEP 3 // Knob detents per mode/steam/backflush step
+#define HA_SCREEN_PREBUILD_MS 3000 // Build the HA screen this long after boot if not swiped to yet (0 = on first swipe only)
 
 
 // --- Global State & UI Objects ---
 lv_obj_t* screen_shot_stopper;
-lv_obj_t* screen_ha;
+lv_obj_t* screen_ha = NULL; // NULL until ensure_ha_screen() builds it
 
 // HA Screen State
 static ha_control_t selected_ha_control = HA_CONTROL_NONE;
@@ -74,6 +92,8 @@ static const char* PREINFUSION_MODES[] = {"Pre-brew", "Pre-infusion", "Disabled"
 static float current_temp = 93.0;
 static int8_t current_steam = 3;
 static float current_preinfusion_time = 0.8;
+static bool current_power_state = false;
+static float current_last_shot = 0;
 
 // Shot Stopper Screen Globals
 lv_obj_t * weight_label;
@@ -82,10 +102,47 @@ lv_obj_t* preset_btns[3];
 lv_obj_t* preset_labels[3];
 lv_obj_t* title_label;
 static lv_obj_t* ble_status_label; // For BLE status
+static lv_obj_t* wifi_status_label; // For Wi-Fi/MQTT status
 static lv_obj_t* battery_label;    // For Battery status
 static int8_t preset_weights[3] = {36, 40, 45}; // Default values if none are saved
-static const char* PRESET_KEYS[3] = {"p1", "p2", "p3"};
-extern Preferences preferences; // Declare external Preferences object
+
+// --- Cached Labels ---
+#define CACHED_LABEL_LEN 24 // Longest rendered value text, including the battery symbol
+
+// Text a label currently shows. The label renders straight from text
+// (lv_label_set_text_static), so an update costs no LVGL allocation.
+typedef struct {
+    lv_obj_t* obj;               // Label text was last written to (NULL = never)
+    char text[CACHED_LABEL_LEN];
+} cached_label_t;
+
+static cached_label_t weight_text;
+static cached_label_t preset_texts[3];
+static cached_label_t battery_text;
+static cached_label_t ha_mode_text;
+static cached_label_t ha_temp_text;
+static cached_label_t ha_steam_text;
+static cached_label_t ha_preinf_time_text;
+static cached_label_t ha_last_shot_text;
+
+// Formats into a scratch buffer and only touches the label if the result differs
+// from what it shows. All value labels are content-sized, so LVGL's invalidation
+// on a change already covers just the old and new text boxes.
+// Returns true if the label was updated.
+static bool cached_label_set_fmt(cached_label_t* cache, lv_obj_t* label, const char* fmt, ...) {
+    if (!label) return false;
+    char buf[CACHED_LABEL_LEN];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (cache->obj == label && strcmp(buf, cache->text) == 0) return false;
+    memcpy(cache->text, buf, sizeof(buf));
+    cache->obj = label; // A rebuilt screen has new label objects, so it always renders once
+    lv_label_set_text_static(label, cache->text);
+    return true;
+}
 
 // Forward Declarations
 void create_ha_screen(lv_obj_t* parent);
@@ -94,8 +151,9 @@ static void deselect_all_ha_controls();
 static void swipe_event_cb(lv_event_t* e);
 void update_preset_label(uint8_t index); // Declare for use in create screen
 void load_presets(); // Declare for use in create screen
-static void battery_timer_cb(lv_timer_t* timer); // Battery timer callback
 static void inactivity_timer_cb(lv_timer_t* timer); // Inactivity timer callback
+static void encoder_timer_cb(lv_timer_t* timer); // Knob batch drain
+static void ensure_ha_screen(); // Builds screen_ha on first use
 void reset_inactivity_timer(); // Declaration for internal use
 
 
@@ -103,7 +161,7 @@ void reset_inactivity_timer(); // Declaration for internal use
 
 // Timer callback to deselect the active HA control after 5 seconds of inactivity
 static void deselect_timer_cb(lv_timer_t* timer) {
-    Serial.println("Deselection timer fired.");
+    LOG_D("Deselection timer fired.");
     deselect_all_ha_controls();
     lv_timer_del(deselection_timer);
     deselection_timer = NULL;
@@ -117,24 +175,31 @@ void ha_ui_reset_deselection_timer() {
 }
 
 // Central handler for all encoder events on the Home Assistant screen
+ha_control_t ha_ui_get_selected_control() {
+    return selected_ha_control;
+}
+
+// direction is a signed, already velocity-scaled step count for this batch
 void ha_ui_handle_encoder_turn(int8_t direction) {
     reset_inactivity_timer(); // Reset brightness on encoder turn
     if (selected_ha_control == HA_CONTROL_NONE) return;
 
     ha_ui_reset_deselection_timer(); // Reset HA control selection timer
 
-    static int8_t mode_counter = 0;
-    static int8_t steam_counter = 0;
-    static int8_t backflush_counter = 0;
+    // Detents not yet used up by a step; a batch can reach +-127 (int16_t leaves room)
+    static int16_t mode_counter = 0;
+    static int16_t steam_counter = 0;
+    static int16_t backflush_counter = 0;
 
     switch (selected_ha_control) {
         case HA_CONTROL_MODE:
             mode_counter += direction;
-            if (abs(mode_counter) >= 3) {
-                current_mode_index = (current_mode_index + (mode_counter > 0 ? 1 : -1) + 3) % 3;
+            if (abs(mode_counter) >= HA_DETENTS_PER_STEP) {
+                int mode_steps = mode_counter / HA_DETENTS_PER_STEP; // A batch may cover several positions
+                current_mode_index = ((current_mode_index + mode_steps) % 3 + 3) % 3;
                 ha_set_preinfusion_mode(current_mode_index);
                 update_ha_mode_ui(current_mode_index);
-                mode_counter = 0;
+                mode_counter -= mode_steps * HA_DETENTS_PER_STEP; // Keep the leftover detents
             }
             break;
         case HA_CONTROL_PREINF_TIME:
@@ -150,20 +215,21 @@ void ha_ui_handle_encoder_turn(int8_t direction) {
             break;
         case HA_CONTROL_STEAM:
             steam_counter += direction;
-            if (abs(steam_counter) >= 3) {
-                current_steam += (steam_counter > 0 ? 1 : -1);
+            if (abs(steam_counter) >= HA_DETENTS_PER_STEP) {
+                int steam_steps = steam_counter / HA_DETENTS_PER_STEP;
+                current_steam += steam_steps;
                 if (current_steam < 1) current_steam = 1;
                 if (current_steam > 3) current_steam = 3;
                 ha_set_steam_power(current_steam);
                 update_ha_steam_power_ui(current_steam);
-                steam_counter = 0;
+                steam_counter -= steam_steps * HA_DETENTS_PER_STEP; // Keep the leftover detents
             }
             break;
         case HA_CONTROL_BACKFLUSH:
             backflush_counter += direction;
-             if (abs(backflush_counter) >= 3) {
+            if (abs(backflush_counter) >= HA_DETENTS_PER_STEP) {
                 ha_trigger_backflush();
-                Serial.println("Backflush activated via encoder.");
+                LOG_I("Backflush activated via encoder.");
                 deselect_all_ha_controls();
                 backflush_counter = 0;
             }
@@ -177,36 +243,39 @@ void ha_ui_handle_encoder_turn(int8_t direction) {
 
 // Callback for the main inactivity timer
 static void inactivity_timer_cb(lv_timer_t* timer) {
-    Serial.printf("Inactivity timer fired. Current brightness level: %d\n", current_brightness_level);
+    LOG_D("Inactivity timer fired. Current brightness level: %d", current_brightness_level);
     if (current_brightness_level == BRIGHTNESS_HIGH) {
-        Serial.println("Dimming screen to 20%");
+        LOG_I("Dimming screen to 20%%");
         setUpdutySubdivide(BRIGHTNESS_DIM);
         current_brightness_level = BRIGHTNESS_DIM;
         // Keep timer running, next timeout will turn screen off
         lv_timer_set_period(timer, INACTIVITY_TIMEOUT_OFF_MS); // Set period for next stage
         lv_timer_reset(timer); // Reset countdown for the next stage
     } else if (current_brightness_level == BRIGHTNESS_DIM) {
-        Serial.println("Turning screen off");
+        LOG_I("Turning screen off");
         setUpdutySubdivide(BRIGHTNESS_OFF);
         current_brightness_level = BRIGHTNESS_OFF;
         lv_timer_pause(timer); // Pause timer when screen is off
+        settings_flush(); // Don't leave unsaved changes pending across a long idle
+        lcd_display_sleep(); // Panel sleep, LVGL tick stopped, LVGL task parked
     }
 }
 
 // Function to reset brightness to high and restart the inactivity timer
 void reset_inactivity_timer() {
     if (current_brightness_level != BRIGHTNESS_HIGH) {
-        Serial.println("Activity detected, setting brightness to high.");
+        LOG_I("Activity detected, setting brightness to high.");
+        lcd_display_wake(); // No-op unless the panel is asleep
         setUpdutySubdivide(BRIGHTNESS_HIGH);
         current_brightness_level = BRIGHTNESS_HIGH;
     }
     if (inactivity_timer) {
-        // Serial.println("Resetting inactivity timer."); // Debug log if needed
+        // LOG_I("Resetting inactivity timer."); // Debug log if needed
         lv_timer_set_period(inactivity_timer, INACTIVITY_TIMEOUT_DIM_MS); // Reset period to initial dim timeout
         lv_timer_reset(inactivity_timer); // Reset countdown
         lv_timer_resume(inactivity_timer); // Ensure it's running
     } else {
-        Serial.println("Error: Inactivity timer not initialized!");
+        LOG_E("Error: Inactivity timer not initialized!");
     }
 }
 
@@ -232,7 +301,7 @@ static void ha_select_event_cb(lv_event_t* e) {
 
     selected_ha_control = control_type;
     lv_obj_add_style(selected_ui_obj, &style_selected, 0);
-    Serial.printf("Selected control: %d\n", control_type);
+    LOG_I("Selected control: %d", control_type);
 
     if (deselection_timer) {
         lv_timer_reset(deselection_timer);
@@ -244,7 +313,7 @@ static void ha_select_event_cb(lv_event_t* e) {
 
 // Manual long press implementation for power button
 static void power_long_press_timer_cb(lv_timer_t* timer) {
-    Serial.println("Power button long-press timer fired.");
+    LOG_I("Power button long-press timer fired.");
     ha_set_machine_power(!lv_obj_has_state(ha_on_off_btn, LV_STATE_CHECKED));
     power_long_press_timer = NULL; // Timer is one-shot, clear its handle
 }
@@ -254,7 +323,7 @@ static void ha_power_press_event_cb(lv_event_t* e) {
     lv_event_code_t code = lv_event_get_code(e);
 
     if (code == LV_EVENT_PRESSED) {
-        Serial.println("Power button pressed, starting 2s timer.");
+        LOG_I("Power button pressed, starting 2s timer.");
         if (power_long_press_timer) {
             lv_timer_del(power_long_press_timer);
         }
@@ -262,7 +331,7 @@ static void ha_power_press_event_cb(lv_event_t* e) {
         lv_timer_set_repeat_count(power_long_press_timer, 1);
     } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
         if (power_long_press_timer) {
-            Serial.println("Power button released, deleting timer.");
+            LOG_D("Power button released, deleting timer.");
             lv_timer_del(power_long_press_timer);
             power_long_press_timer = NULL;
         }
@@ -276,16 +345,18 @@ static void swipe_event_cb(lv_event_t* e) {
     if(indev == NULL) return; // Should not happen with gestures
 
     lv_dir_t dir = lv_indev_get_gesture_dir(indev);
-    Serial.printf("Swipe event detected! Direction: %d\n", dir); // DEBUG
+    LOG_D("Swipe event detected! Direction: %d", dir); // DEBUG
 
     if (dir == LV_DIR_TOP) {
-        Serial.println("Swiped UP - Loading HA screen."); // DEBUG
+        LOG_D("Swiped UP - Loading HA screen."); // DEBUG
+        ensure_ha_screen();
+        if (!screen_ha) return;
         lv_scr_load_anim(screen_ha, LV_SCR_LOAD_ANIM_MOVE_TOP, 300, 0, false);
     } else if (dir == LV_DIR_BOTTOM) {
-        Serial.println("Swiped DOWN - Loading Shot Stopper screen."); // DEBUG
+        LOG_D("Swiped DOWN - Loading Shot Stopper screen."); // DEBUG
         lv_scr_load_anim(screen_shot_stopper, LV_SCR_LOAD_ANIM_MOVE_BOTTOM, 300, 0, false);
     } else {
-         Serial.println("Swipe direction not vertical."); // DEBUG
+         LOG_D("Swipe direction not vertical."); // DEBUG
     }
 }
 
@@ -297,31 +368,37 @@ void create_ha_screen(lv_obj_t* parent) {
     lv_style_set_border_width(&style_selected, 3);
     lv_style_set_border_side(&style_selected, LV_BORDER_SIDE_FULL);
 
-    // Object map for storing name-to-object mappings
-    #define HA_OBJ_MAP_SIZE 20
-    static lvgl_xml_obj_map_t obj_map[HA_OBJ_MAP_SIZE];
-    
+    // Name index for this screen (owns copies of the object names)
+    static lvgl_ui_index_t ui_index;
+#if LVGL_UI_USE_COMPILED
+    lvgl_ui_index_reserve(&ui_index, HOME_ASSISTANT_SCREEN_OBJ_COUNT);
+#endif
+
+    int64_t build_start = esp_timer_get_time();
+#if LVGL_UI_USE_COMPILED
+    lv_obj_t* loaded_screen = lvgl_ui_load_ops(home_assistant_screen_ops, HOME_ASSISTANT_SCREEN_OP_COUNT, parent, &ui_index);
+#else
     // Load XML from embedded string
-    const char* xml_string = home_assistant_screen_xml;
-    
-    lv_obj_t* loaded_screen = lvgl_xml_load_from_string(xml_string, parent, obj_map, HA_OBJ_MAP_SIZE);
+    lv_obj_t* loaded_screen = lvgl_xml_load_from_string(home_assistant_screen_xml, parent, &ui_index);
+#endif
     if (!loaded_screen) {
-        Serial.println("ERROR: Failed to load HA screen from XML!");
+        LOG_E("ERROR: Failed to load HA screen!");
         return;
     }
+    LOG_I("HA screen built in %lld us", (long long)(esp_timer_get_time() - build_start));
     
-    // Find objects by name and store in global pointers
-    ha_on_off_btn = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_on_off_btn");
-    ha_mode_cont = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_mode_cont");
-    ha_mode_label = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_mode_label");
-    ha_preinf_time_cont = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_preinf_time_cont");
-    ha_preinf_time_label = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_preinf_time_label");
-    ha_temp_cont = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_temp_cont");
-    ha_temp_label = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_temp_label");
-    ha_steam_cont = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_steam_cont");
-    ha_steam_label = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_steam_label");
-    ha_backflush_cont = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_backflush_cont");
-    ha_last_shot_label = lvgl_xml_find_object(obj_map, HA_OBJ_MAP_SIZE, "ha_last_shot_label");
+    // Find objects by name and store in global pointers (hashes folded at compile time)
+    ha_on_off_btn = LVGL_UI_FIND(&ui_index, "ha_on_off_btn");
+    ha_mode_cont = LVGL_UI_FIND(&ui_index, "ha_mode_cont");
+    ha_mode_label = LVGL_UI_FIND(&ui_index, "ha_mode_label");
+    ha_preinf_time_cont = LVGL_UI_FIND(&ui_index, "ha_preinf_time_cont");
+    ha_preinf_time_label = LVGL_UI_FIND(&ui_index, "ha_preinf_time_label");
+    ha_temp_cont = LVGL_UI_FIND(&ui_index, "ha_temp_cont");
+    ha_temp_label = LVGL_UI_FIND(&ui_index, "ha_temp_label");
+    ha_steam_cont = LVGL_UI_FIND(&ui_index, "ha_steam_cont");
+    ha_steam_label = LVGL_UI_FIND(&ui_index, "ha_steam_label");
+    ha_backflush_cont = LVGL_UI_FIND(&ui_index, "ha_backflush_cont");
+    ha_last_shot_label = LVGL_UI_FIND(&ui_index, "ha_last_shot_label");
     
     // Update on/off button label with symbol (XML doesn't support LV_SYMBOL_POWER directly)
     if (ha_on_off_btn) {
@@ -364,48 +441,65 @@ void create_ha_screen(lv_obj_t* parent) {
     update_ha_preinfusion_time_ui(current_preinfusion_time);
     update_ha_temperature_ui(current_temp);
     update_ha_steam_power_ui(current_steam);
-    update_ha_last_shot_ui(0);
+    update_ha_last_shot_ui(current_last_shot);
+    update_ha_power_switch_ui(current_power_state);
 }
 
-// --- Battery Timer Callback ---
-static void battery_timer_cb(lv_timer_t* timer) {
-    // Read voltage (mV). The divider is 100k+100k, so Vbat = V_adc * 2
-    uint32_t current_reading_mv = analogReadMilliVolts(BATTERY_ADC_PIN) * 2;
+// Builds the HA screen the first time it is needed
+static void ensure_ha_screen() {
+    if (screen_ha) return;
 
-    // Initialize filter on first run
-    if (!battery_filter_initialized) {
-        for (int i = 0; i < BATTERY_READING_COUNT; i++) {
-            battery_readings[i] = current_reading_mv;
-        }
-        battery_reading_sum = current_reading_mv * BATTERY_READING_COUNT;
-        battery_filter_initialized = true;
-    } else {
-        // Subtract the oldest reading from the sum
-        battery_reading_sum -= battery_readings[battery_reading_index];
-        // Add the new reading to the sum
-        battery_reading_sum += current_reading_mv;
-        // Store the new reading, replacing the oldest
-        battery_readings[battery_reading_index] = current_reading_mv;
+    lv_obj_t* screen = lv_obj_create(NULL);
+    if (!screen) {
+        LOG_E("ERROR: Failed to create HA screen!");
+        return;
     }
+    screen_ha = screen; // Set before building so the update_ha_* calls see it
+    create_ha_screen(screen_ha);
+    lv_obj_add_event_cb(screen_ha, swipe_event_cb, LV_EVENT_GESTURE, NULL);
+    telemetry_sample_lvgl(); // Screen builds are the LVGL heap's high-water moments
+}
 
-    // Calculate the average voltage
-    uint32_t average_mv = battery_reading_sum / BATTERY_READING_COUNT;
-
-    // Move to the next index
-    battery_reading_index = (battery_reading_index + 1) % BATTERY_READING_COUNT;
-
-
-    // Calculate percentage based on the AVERAGE voltage
-    int percentage = (int)(((float)average_mv - BATTERY_MIN_MV) / (BATTERY_MAX_MV - BATTERY_MIN_MV) * 100.0f);
-
-    // Clamp percentage between 0 and 100
-    if (percentage < 0) percentage = 0;
-    if (percentage > 100) percentage = 100;
+#if HA_SCREEN_PREBUILD_MS > 0
+static void ha_prebuild_timer_cb(lv_timer_t* timer) {
+    ensure_ha_screen(); // One-shot; no-op if a swipe already built it
+}
+#endif
+
+// --- Event Bus ---
+// Applies everything posted to the event bus since the last cycle. Called by the
+// LVGL task (lock held) right before lv_timer_handler(), so all widget changes
+// happen on the LVGL task and a burst of posts costs one redraw.
+void lvgl_display_process_events() {
+    app_event_value_t v[APP_EVT_COUNT];
+    uint32_t mask = app_events_take(v);
+    if (mask == 0) return;
+
+    if (mask & (1UL << APP_EVT_BLE_STATUS))          update_ble_status((ble_status_t)v[APP_EVT_BLE_STATUS].i);
+    if (mask & (1UL << APP_EVT_NET_STATUS))          update_net_status((net_status_t)v[APP_EVT_NET_STATUS].i);
+    // Before CONFIRMED: a hide and a later confirm in the same cycle end up shown
+    if (mask & (1UL << APP_EVT_WEIGHT_UNVERIFIED))   hide_verification_checkmark();
+    if (mask & (1UL << APP_EVT_WEIGHT_CONFIRMED)) {
+        update_display_value((int8_t)v[APP_EVT_WEIGHT_CONFIRMED].i);
+        show_verification_checkmark();
+    }
+    if (mask & (1UL << APP_EVT_BATTERY))             update_battery_status((uint8_t)v[APP_EVT_BATTERY].i);
+    if (mask & (1UL << APP_EVT_HA_POWER))            update_ha_power_switch_ui(v[APP_EVT_HA_POWER].b);
+    if (mask & (1UL << APP_EVT_HA_MODE))             update_ha_mode_ui((int8_t)v[APP_EVT_HA_MODE].i);
+    if (mask & (1UL << APP_EVT_HA_TEMPERATURE))      update_ha_temperature_ui(v[APP_EVT_HA_TEMPERATURE].f);
+    if (mask & (1UL << APP_EVT_HA_STEAM_POWER))      update_ha_steam_power_ui(v[APP_EVT_HA_STEAM_POWER].i);
+    if (mask & (1UL << APP_EVT_HA_PREINFUSION_TIME)) update_ha_preinfusion_time_ui(v[APP_EVT_HA_PREINFUSION_TIME].f);
+    if (mask & (1UL << APP_EVT_HA_LAST_SHOT))        update_ha_last_shot_ui(v[APP_EVT_HA_LAST_SHOT].f);
+}
 
-    // Serial.printf("Battery mV (Avg): %lu, Percentage: %d%%\n", average_mv, percentage); // Debug
+// --- Encoder ---
+static void encoder_timer_cb(lv_timer_t* timer) {
+    encoder_ui_poll();
+}
 
-    // Update the UI
-    update_battery_status((uint8_t)percentage);
+// --- Telemetry ---
+static void telemetry_timer_cb(lv_timer_t* timer) {
+    telemetry_sample_lvgl(); // lv_mem_monitor must run on the LVGL task
 }
 
 
@@ -414,10 +508,8 @@ void lvgl_display_init() {
     // Note: lv_init() is called in lcd_lvgl_Init() in lcd_bsp.c
 
     screen_shot_stopper = lv_obj_create(NULL);
-    screen_ha = lv_obj_create(NULL);
-
     create_shot_stopper_screen(screen_shot_stopper);
-    create_ha_screen(screen_ha);
+    // screen_ha is built on demand by ensure_ha_screen()
 
     // Removed GESTURE_BUBBLE flags
     // lv_obj_add_flag(screen_shot_stopper, LV_OBJ_FLAG_GESTURE_BUBBLE);
@@ -425,56 +517,54 @@ void lvgl_display_init() {
 
     // Add event callbacks directly to screens
     lv_obj_add_event_cb(screen_shot_stopper, swipe_event_cb, LV_EVENT_GESTURE, NULL);
-    lv_obj_add_event_cb(screen_ha, swipe_event_cb, LV_EVENT_GESTURE, NULL);
 
     lv_disp_load_scr(screen_shot_stopper);
 
-    // Create a timer to update the battery status every 5 seconds (5000 ms)
-    lv_timer_create(battery_timer_cb, 5000, NULL);
-    // Call it once immediately to show initial status
-    battery_timer_cb(NULL); // Call initial update
-    Serial.println("Battery update timer created."); // Confirm timer creation
+    // The battery label is driven by APP_EVT_BATTERY from battery.cpp
 
     // Create the main inactivity timer, initially set for the first dim timeout
     inactivity_timer = lv_timer_create(inactivity_timer_cb, INACTIVITY_TIMEOUT_DIM_MS, NULL);
-    Serial.println("Inactivity timer created.");
+    LOG_I("Inactivity timer created.");
+
+    // Apply knob turns on the LVGL task, one batch per frame
+    lv_timer_create(encoder_timer_cb, ENCODER_UI_POLL_MS, NULL);
+
+    lv_timer_create(telemetry_timer_cb, TELEMETRY_LVGL_SAMPLE_MS, NULL);
+
+#if HA_SCREEN_PREBUILD_MS > 0
+    // Build the secondary screen once the first frame is up and the UI is idle
+    lv_timer_t* prebuild_timer = lv_timer_create(ha_prebuild_timer_cb, HA_SCREEN_PREBUILD_MS, NULL);
+    lv_timer_set_repeat_count(prebuild_timer, 1);
+#endif
 
 }
 
 // --- HA UI Update Functions ---
 void update_ha_power_switch_ui(bool state) {
+    current_power_state = state;
     if (ha_on_off_btn) {
         state ? lv_obj_add_state(ha_on_off_btn, LV_STATE_CHECKED) : lv_obj_clear_state(ha_on_off_btn, LV_STATE_CHECKED);
     }
 }
 void update_ha_mode_ui(int8_t mode_index) {
     current_mode_index = mode_index;
-    if (ha_mode_label) {
-        lv_label_set_text(ha_mode_label, PREINFUSION_MODES[current_mode_index]);
-    }
+    cached_label_set_fmt(&ha_mode_text, ha_mode_label, "%s", PREINFUSION_MODES[current_mode_index]);
 }
 void update_ha_temperature_ui(float temp) {
     current_temp = temp;
-    if (ha_temp_label) {
-        lv_label_set_text_fmt(ha_temp_label, "%.1f C", current_temp);
-    }
+    cached_label_set_fmt(&ha_temp_text, ha_temp_label, "%.1f C", current_temp);
 }
 void update_ha_steam_power_ui(int power) {
     current_steam = power;
-    if (ha_steam_label) {
-        lv_label_set_text_fmt(ha_steam_label, "Pwr: %d", current_steam);
-    }
+    cached_label_set_fmt(&ha_steam_text, ha_steam_label, "Pwr: %d", current_steam);
 }
 void update_ha_preinfusion_time_ui(float time) {
     current_preinfusion_time = time;
-    if (ha_preinf_time_label) {
-        lv_label_set_text_fmt(ha_preinf_time_label, "%.1fs", current_preinfusion_time);
-    }
+    cached_label_set_fmt(&ha_preinf_time_text, ha_preinf_time_label, "%.1fs", current_preinfusion_time);
 }
 void update_ha_last_shot_ui(float seconds) {
-    if (ha_last_shot_label) {
-        lv_label_set_text_fmt(ha_last_shot_label, "Last: %.1fs", seconds);
-    }
+    current_last_shot = seconds;
+    cached_label_set_fmt(&ha_last_shot_text, ha_last_shot_label, "Last: %.1fs", seconds);
 }
 
 // --- Shot Stopper Screen Code ---
@@ -484,97 +574,108 @@ void update_ha_last_shot_ui(float seconds) {
 
 // Update the label for a specific preset button
 void update_preset_label(uint8_t index) {
-    if (index < 3 && preset_labels[index]) {
-        char buf[16];
-        sprintf(buf, "%d g", preset_weights[index]);
-        lv_label_set_text(preset_labels[index], buf);
+    if (index < 3) {
+        cached_label_set_fmt(&preset_texts[index], preset_labels[index], "%d g", preset_weights[index]);
     }
 }
 
-// Load presets from NVS and update the UI
+// Load presets from the settings shadow and update the UI
 void load_presets() {
-    Serial.println("Loading presets from memory...");
-    if (!preferences.isKey("p1")) { // Check if preferences have been initialized
-         Serial.println("Preferences not found, using defaults.");
+    LOG_I("Loading presets from memory...");
+    if (!settings_is_set(SETTING_PRESET_1)) { // Check if presets have ever been saved
+         LOG_W("Presets not found, using defaults.");
     }
     for (int i = 0; i < 3; i++) {
-        // Get the value from preferences, using the hardcoded default if it's not found
-        preset_weights[i] = preferences.getChar(PRESET_KEYS[i], preset_weights[i]);
+        // Get the saved value, using the hardcoded default if it's not found
+        preset_weights[i] = settings_get_i8((setting_id_t)(SETTING_PRESET_1 + i), preset_weights[i]);
         update_preset_label(i); // Update the label after loading
-        Serial.printf("  Preset %d loaded with value: %d g\n", i + 1, preset_weights[i]);
+        LOG_I("  Preset %d loaded with value: %d g", i + 1, preset_weights[i]);
     }
 }
 
 // Event handler for preset buttons (short click and long press)
 static void preset_event_cb(lv_event_t * e) {
     reset_inactivity_timer(); // Reset brightness on touch
-    Serial.println("Preset button callback fired!"); // DEBUG: Confirm callback fires
+    LOG_D("Preset button callback fired!"); // DEBUG: Confirm callback fires
     lv_event_code_t code = lv_event_get_code(e);
     intptr_t preset_index = (intptr_t)lv_event_get_user_data(e);
 
-    if (code == LV_EVENT_SHORT_CLICKED) {
-        Serial.printf("Preset %ld tapped. Loading weight: %d g\n", preset_index + 1, preset_weights[preset_index]);
+    if (code == LV_EVENT_PRESSED) {
+        // Likely a tap: get the link up while the finger is still down
+        ble_prepare_write();
+
+    } else if (code == LV_EVENT_SHORT_CLICKED) {
+        LOG_D("Preset %ld tapped. Loading weight: %d g", preset_index + 1, preset_weights[preset_index]);
 
         target_weight = preset_weights[preset_index];
 
         hide_verification_checkmark();
         update_display_value(target_weight); // Update UI immediately
 
-        // Reset the debounce timer instead of writing directly
+        // A tap is a final value, unlike knob detents: no debounce. Cancel a pending
+        // knob write so it can't overwrite the preset a second later.
         if (ble_write_timer != NULL) {
-             Serial.printf("Resetting BLE write timer for preset %ld\n", preset_index + 1);
-            xTimerReset(ble_write_timer, portMAX_DELAY); // Reset timer to 1 second
-        } else {
-             Serial.println("Error: ble_write_timer is NULL!");
+            xTimerStop(ble_write_timer, 0);
         }
-        // write_target_weight(target_weight); // REMOVED - Timer callback handles this
+        LOG_I("Writing preset %ld (%d g) now.", preset_index + 1, target_weight);
+        write_target_weight(target_weight);
 
     } else if (code == LV_EVENT_LONG_PRESSED) {
-        Serial.printf("Preset %ld long-pressed. Saving current weight: %d g\n", preset_index + 1, target_weight);
+        LOG_D("Preset %ld long-pressed. Saving current weight: %d g", preset_index + 1, target_weight);
 
         preset_weights[preset_index] = target_weight;
         update_preset_label(preset_index);
 
-        // Save the new preset value to non-volatile storage
-        preferences.putChar(PRESET_KEYS[preset_index], target_weight);
-        Serial.printf("Preset %ld saved to memory.\n", preset_index + 1);
+        // Committed to flash by the settings writer after a quiet period
+        settings_set_i8((setting_id_t)(SETTING_PRESET_1 + preset_index), target_weight);
+        LOG_D("Preset %ld saved to memory.", preset_index + 1);
     }
 }
 
 // Create the Shot Stopper Screen UI (XML-based)
 void create_shot_stopper_screen(lv_obj_t* parent) {
-    // Object map for storing name-to-object mappings
-    #define SHOT_STOPPER_OBJ_MAP_SIZE 20
-    static lvgl_xml_obj_map_t obj_map[SHOT_STOPPER_OBJ_MAP_SIZE];
-    
+    // Name index for this screen (owns copies of the object names)
+    static lvgl_ui_index_t ui_index;
+#if LVGL_UI_USE_COMPILED
+    lvgl_ui_index_reserve(&ui_index, SHOT_STOPPER_SCREEN_OBJ_COUNT);
+#endif
+
+    int64_t build_start = esp_timer_get_time();
+#if LVGL_UI_USE_COMPILED
+    lv_obj_t* loaded_screen = lvgl_ui_load_ops(shot_stopper_screen_ops, SHOT_STOPPER_SCREEN_OP_COUNT, parent, &ui_index);
+#else
     // Load XML from embedded string
-    const char* xml_string = shot_stopper_screen_xml;
-    
-    lv_obj_t* loaded_screen = lvgl_xml_load_from_string(xml_string, parent, obj_map, SHOT_STOPPER_OBJ_MAP_SIZE);
+    lv_obj_t* loaded_screen = lvgl_xml_load_from_string(shot_stopper_screen_xml, parent, &ui_index);
+#endif
     if (!loaded_screen) {
-        Serial.println("ERROR: Failed to load Shot Stopper screen from XML!");
+        LOG_E("ERROR: Failed to load Shot Stopper screen!");
         return;
     }
+    LOG_I("Shot Stopper screen built in %lld us", (long long)(esp_timer_get_time() - build_start));
     
-    // Find objects by name and store in global pointers
-    ble_status_label = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "ble_status_label");
-    title_label = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "title_label");
-    weight_label = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "weight_label");
-    checkmark_label = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "checkmark_label");
-    battery_label = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "battery_label");
+    // Find objects by name and store in global pointers (hashes folded at compile time)
+    ble_status_label = LVGL_UI_FIND(&ui_index, "ble_status_label");
+    wifi_status_label = LVGL_UI_FIND(&ui_index, "wifi_status_label");
+    title_label = LVGL_UI_FIND(&ui_index, "title_label");
+    weight_label = LVGL_UI_FIND(&ui_index, "weight_label");
+    checkmark_label = LVGL_UI_FIND(&ui_index, "checkmark_label");
+    battery_label = LVGL_UI_FIND(&ui_index, "battery_label");
     
     // Find preset buttons and labels
-    preset_btns[0] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_btn_0");
-    preset_btns[1] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_btn_1");
-    preset_btns[2] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_btn_2");
-    preset_labels[0] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_label_0");
-    preset_labels[1] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_label_1");
-    preset_labels[2] = lvgl_xml_find_object(obj_map, SHOT_STOPPER_OBJ_MAP_SIZE, "preset_label_2");
+    preset_btns[0] = LVGL_UI_FIND(&ui_index, "preset_btn_0");
+    preset_btns[1] = LVGL_UI_FIND(&ui_index, "preset_btn_1");
+    preset_btns[2] = LVGL_UI_FIND(&ui_index, "preset_btn_2");
+    preset_labels[0] = LVGL_UI_FIND(&ui_index, "preset_label_0");
+    preset_labels[1] = LVGL_UI_FIND(&ui_index, "preset_label_1");
+    preset_labels[2] = LVGL_UI_FIND(&ui_index, "preset_label_2");
     
     // Update BLE status label with symbol (XML doesn't support LV_SYMBOL_BLUETOOTH directly)
     if (ble_status_label) {
         lv_label_set_text(ble_status_label, LV_SYMBOL_BLUETOOTH);
     }
+    if (wifi_status_label) {
+        lv_label_set_text(wifi_status_label, LV_SYMBOL_WIFI);
+    }
     
     // Update checkmark label with symbol
     if (checkmark_label) {
@@ -598,9 +699,8 @@ void create_shot_stopper_screen(lv_obj_t* parent) {
 
 // Update the main weight display
 void update_display_value(int8_t weight) {
-    if(weight_label) {
-        lv_label_set_text_fmt(weight_label, "%d g", weight);
-        Serial.printf("Display updated to: %d g\n", weight);
+    if (cached_label_set_fmt(&weight_text, weight_label, "%d g", weight)) {
+        LOG_I("Display updated to: %d g", weight);
     }
 }
 
@@ -608,13 +708,13 @@ void update_display_value(int8_t weight) {
 void show_verification_checkmark() {
     if (checkmark_label) {
         lv_obj_clear_flag(checkmark_label, LV_OBJ_FLAG_HIDDEN);
-        Serial.println("Checkmark displayed.");
+        LOG_I("Checkmark displayed.");
     }
 }
 void hide_verification_checkmark() {
     if (checkmark_label) {
         lv_obj_add_flag(checkmark_label, LV_OBJ_FLAG_HIDDEN);
-        Serial.println("Checkmark hidden.");
+        LOG_I("Checkmark hidden.");
     }
 }
 
@@ -638,34 +738,61 @@ void update_ble_status(ble_status_t status) {
     }
 }
 
+// Update Wi-Fi/MQTT status icon color
+void update_net_status(net_status_t status) {
+    if (!wifi_status_label) return;
+    switch (status) {
+        case NET_STATUS_OFFLINE:
+            lv_obj_set_style_text_color(wifi_status_label, lv_color_make(220, 53, 69), 0); // Red
+            break;
+        case NET_STATUS_WIFI_CONNECTING:
+            lv_obj_set_style_text_color(wifi_status_label, lv_color_make(128, 128, 128), 0); // Grey
+            break;
+        case NET_STATUS_MQTT_CONNECTING:
+            lv_obj_set_style_text_color(wifi_status_label, lv_color_make(0, 123, 255), 0); // Blue
+            break;
+        case NET_STATUS_ONLINE:
+            lv_obj_set_style_text_color(wifi_status_label, lv_color_make(40, 167, 69), 0); // Green
+            break;
+    }
+}
+
 // New function to update battery status label
 void update_battery_status(uint8_t percentage) {
-    if (battery_label) {
-        // Use battery symbol if available in font, otherwise just text
-        #ifdef LV_SYMBOL_BATTERY_FULL // Check if symbol is defined
-            // Simple logic: show different symbols based on percentage
-            if (percentage > 85) {
-                lv_label_set_text_fmt(battery_label, LV_SYMBOL_BATTERY_FULL " %d%%", percentage);
-                lv_obj_set_style_text_color(battery_label, lv_color_make(0, 255, 0), 0);
-            } else if (percentage > 60) {
-                 lv_label_set_text_fmt(battery_label, LV_SYMBOL_BATTERY_3 " %d%%", percentage);
-                 lv_obj_set_style_text_color(battery_label, lv_color_make(123, 255, 0), 0);
-            } else if (percentage > 30) {
-                 lv_label_set_text_fmt(battery_label, LV_SYMBOL_BATTERY_2 " %d%%", percentage);
-                 lv_obj_set_style_text_color(battery_label, lv_color_make(217, 255, 0), 0);
-            } else if (percentage > 15) {
-                 lv_label_set_text_fmt(battery_label, LV_SYMBOL_BATTERY_1 " %d%%", percentage);
-                 lv_obj_set_style_text_color(battery_label, lv_color_make(255, 157, 0), 0);
-            } else {
-                 lv_label_set_text_fmt(battery_label, LV_SYMBOL_BATTERY_EMPTY " %d%%", percentage);
-                 lv_obj_set_style_text_color(battery_label, lv_color_make(255, 0, 0), 0);
-            }
-        #else // Fallback if symbols aren't defined/enabled
-            lv_label_set_text_fmt(battery_label, "Batt: %d%%", percentage);
-        #endif
-       // Serial.printf("Updating battery label: %d%%\n", percentage); // Debug
-    } else {
-       // Serial.println("Battery label object does not exist!"); // Debug
-    }
+    if (!battery_label) {
+       // LOG_I("Battery label object does not exist!"); // Debug
+       return;
+    }
+    // Use battery symbol if available in font, otherwise just text
+    #ifdef LV_SYMBOL_BATTERY_FULL // Check if symbol is defined
+        // Simple logic: show different symbols based on percentage
+        static const struct {
+            uint8_t above;
+            const char* symbol;
+            uint8_t r, g, b;
+        } bands[] = {
+            {85, LV_SYMBOL_BATTERY_FULL,  0, 255, 0},
+            {60, LV_SYMBOL_BATTERY_3,     123, 255, 0},
+            {30, LV_SYMBOL_BATTERY_2,     217, 255, 0},
+            {15, LV_SYMBOL_BATTERY_1,     255, 157, 0},
+            {0,  LV_SYMBOL_BATTERY_EMPTY, 255, 0, 0},
+        };
+        static lv_obj_t* colored_label = NULL; // Label the band color was applied to
+        static int colored_band = -1;
+        int band = 0;
+        while (band < 4 && percentage <= bands[band].above) band++;
+
+        if (!cached_label_set_fmt(&battery_text, battery_label, "%s %d%%", bands[band].symbol, percentage)) {
+            return; // Same text, same band: nothing to redraw
+        }
+        if (band != colored_band || colored_label != battery_label) {
+            lv_obj_set_style_text_color(battery_label, lv_color_make(bands[band].r, bands[band].g, bands[band].b), 0);
+            colored_band = band;
+            colored_label = battery_label;
+        }
+    #else // Fallback if symbols aren't defined/enabled
+        cached_label_set_fmt(&battery_text, battery_label, "Batt: %d%%", percentage);
+    #endif
+    // LOG_I("Updating battery label: %d%%", percentage); // Debug
 }
 
@@ -1,9 +1,11 @@
 /*
  * Header for the LVGL display module.
  *
- * Declares the functions for initializing the UI and updating its elements.
- * Added update_battery_status function.
- * Added reset_inactivity_timer function.
+ * Declares the functions for initializing the UI, updating its elements
+ * (weight, BLE, Wi-Fi/MQTT and battery status, HA controls) and the
+ * inactivity timer. screen_ha is NULL until the HA screen has been built.
+ * The update_* functions must only be called from the LVGL task; other tasks
+ * post to the event bus (app_events.h).
  */
 #ifndef LVGL_DISPLAY_H
 #define LVGL_DISPLAY_H
@@ -33,11 +35,15 @@ extern "C" {
 // LVGL UI Initialization
 void lvgl_display_init();
 
+// Applies pending event bus values to the widgets (LVGL task, once per cycle)
+void lvgl_display_process_events();
+
 // Shot Stopper Screen Updates
 void update_display_value(int8_t weight);
 void show_verification_checkmark();
 void hide_verification_checkmark();
 void update_ble_status(ble_status_t status);
+void update_net_status(net_status_t status);
 void update_battery_status(uint8_t percentage);
 
 // Home Assistant Screen Updates
@@ -51,11 +57,12 @@ void update_ha_last_shot_ui(float seconds);
 // Functions called by Encoder/Input handlers
 void ha_ui_handle_encoder_turn(int8_t direction);
 void ha_ui_reset_deselection_timer();
+ha_control_t ha_ui_get_selected_control();
 void reset_inactivity_timer(); // New function for brightness
 
 // Expose screen pointers for encoder logic
 extern lv_obj_t* screen_shot_stopper;
-extern lv_obj_t* screen_ha;
+extern lv_obj_t* screen_ha; // NULL until first built (lazy)
 
 
 #ifdef __cplusplus
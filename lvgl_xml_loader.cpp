@@ -1,6 +1,8 @@
 /*
  * LVGL XML Loader implementation.
- * Simple XML parser for LVGL UI definitions compatible with LVGL Online Editor format.
+ * Simple XML parser for LVGL UI definitions compatible with LVGL Online Editor
+ * format, plus an interpreter for the precompiled widget-op streams. Named
+ * objects go into a hashed, arena-backed name index.
  */
 
 #include "lvgl_xml_loader.h"
@@ -8,6 +10,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define LVGL_UI_MAX_DEPTH 8 // Maximum nesting of BEGIN/END in an op stream
+#define LVGL_UI_INDEX_MIN_CAPACITY 16 // Slots allocated on first insert
+#define LVGL_UI_ARENA_MIN_CAPACITY 256 // Name bytes allocated on first insert
+
 // Simple XML attribute structure
 typedef struct {
     char name[32];
@@ -232,7 +238,7 @@ static lv_obj_t* create_object_from_xml(xml_element_t* elem, lv_obj_t* parent) {
 
 // Simple recursive XML parser (handles basic nested structures)
 static lv_obj_t* parse_xml_recursive(const char** xml_ptr, lv_obj_t* parent, 
-                                     lvgl_xml_obj_map_t* obj_map, uint16_t* obj_map_idx, uint16_t obj_map_size) {
+                                     lvgl_ui_index_t* index) {
     const char* s = *xml_ptr;
     s = skip_whitespace(s);
     
@@ -277,10 +283,9 @@ static lv_obj_t* parse_xml_recursive(const char** xml_ptr, lv_obj_t* parent,
     
     // Store in object map if name is provided
     const char* name = get_attr_value(&elem, "name");
-    if (name && obj_map && *obj_map_idx < obj_map_size) {
-        obj_map[*obj_map_idx].name = name;
-        obj_map[*obj_map_idx].obj = obj;
-        (*obj_map_idx)++;
+    if (name && index) {
+        // Copied into the index arena; elem goes out of scope when we return
+        lvgl_ui_index_add(index, lvgl_ui_hash_str(name), name, obj);
     }
     
     if (self_closing) {
@@ -314,7 +319,7 @@ static lv_obj_t* parse_xml_recursive(const char** xml_ptr, lv_obj_t* parent,
     
     // Parse child elements
     while (*s == '<' && s[1] != '/') {
-        lv_obj_t* child = parse_xml_recursive(&s, obj, obj_map, obj_map_idx, obj_map_size);
+        lv_obj_t* child = parse_xml_recursive(&s, obj, index);
         if (child) {
             // Child already added to parent
         }
@@ -332,19 +337,9 @@ static lv_obj_t* parse_xml_recursive(const char** xml_ptr, lv_obj_t* parent,
     return obj;
 }
 
-lv_obj_t* lvgl_xml_load_from_string(const char* xml_string, lv_obj_t* parent, 
-                                     lvgl_xml_obj_map_t* obj_map, uint16_t obj_map_size) {
+lv_obj_t* lvgl_xml_load_from_string(const char* xml_string, lv_obj_t* parent, lvgl_ui_index_t* index) {
     if (!xml_string) return NULL;
     
-    // Initialize object map
-    if (obj_map) {
-        for (uint16_t i = 0; i < obj_map_size; i++) {
-            obj_map[i].name = NULL;
-            obj_map[i].obj = NULL;
-        }
-    }
-    
-    uint16_t obj_map_idx = 0;
     const char* xml_ptr = xml_string;
     
     // Skip XML declaration if present
@@ -353,17 +348,202 @@ lv_obj_t* lvgl_xml_load_from_string(const char* xml_string, lv_obj_t* parent,
         if (*xml_ptr == '>') xml_ptr++;
     }
     
-    return parse_xml_recursive(&xml_ptr, parent, obj_map, &obj_map_idx, obj_map_size);
+    return parse_xml_recursive(&xml_ptr, parent, index);
 }
 
-lv_obj_t* lvgl_xml_find_object(lvgl_xml_obj_map_t* obj_map, uint16_t obj_map_size, const char* name) {
-    if (!obj_map || !name) return NULL;
-    
-    for (uint16_t i = 0; i < obj_map_size; i++) {
-        if (obj_map[i].name && strcmp(obj_map[i].name, name) == 0) {
-            return obj_map[i].obj;
+lv_obj_t* lvgl_ui_load_ops(const lvgl_ui_op_t* ops, uint16_t op_count, lv_obj_t* parent, lvgl_ui_index_t* index) {
+    if (!ops) return NULL;
+
+    lv_obj_t* stack[LVGL_UI_MAX_DEPTH + 1];
+    int depth = 0;
+    stack[0] = parent;
+    lv_obj_t* root = NULL;
+    lv_obj_t* obj = NULL;
+
+    for (uint16_t i = 0; i < op_count; i++) {
+        const lvgl_ui_op_t* op = &ops[i];
+
+        if (op->op == LVGL_UI_OP_BEGIN) {
+            if (depth >= LVGL_UI_MAX_DEPTH) {
+                Serial.println("ERROR: UI op stream nested too deeply!");
+                return root;
+            }
+            lv_obj_t* p = stack[depth];
+            if (op->arg == LVGL_UI_LABEL) obj = lv_label_create(p);
+            else if (op->arg == LVGL_UI_BTN) obj = lv_btn_create(p);
+            else obj = lv_obj_create(p);
+            if (!obj) return root;
+
+            if (!root) root = obj;
+            stack[++depth] = obj;
+
+            if (op->ptr && index) {
+                lvgl_ui_index_add(index, op->value, (const char*)op->ptr, obj); // Hash precomputed by ui_compile.py
+            }
+            continue;
+        }
+
+        if (op->op == LVGL_UI_OP_END) {
+            if (depth > 0) depth--;
+            obj = stack[depth];
+            continue;
+        }
+
+        if (!obj) continue; // Attribute op outside any object
+
+        switch (op->op) {
+            case LVGL_UI_OP_SIZE:
+                lv_obj_set_size(obj, op->x, op->y);
+                break;
+            case LVGL_UI_OP_ALIGN:
+                lv_obj_align(obj, (lv_align_t)op->arg, op->x, op->y);
+                break;
+            case LVGL_UI_OP_BG_COLOR:
+                lv_obj_set_style_bg_color(obj, lv_color_hex(op->value), 0);
+                break;
+            case LVGL_UI_OP_TEXT_COLOR:
+                lv_obj_set_style_text_color(obj, lv_color_hex(op->value), 0);
+                break;
+            case LVGL_UI_OP_FONT:
+                lv_obj_set_style_text_font(obj, (const lv_font_t*)op->ptr, 0);
+                break;
+            case LVGL_UI_OP_TEXT:
+                // Static text in flash; LVGL does not need its own copy
+                lv_label_set_text_static(obj, (const char*)op->ptr);
+                if (op->arg && stack[depth - 1]) {
+                    lv_obj_center(obj);
+                }
+                break;
+            case LVGL_UI_OP_ADD_FLAG:
+                lv_obj_add_flag(obj, (lv_obj_flag_t)op->value);
+                break;
+            case LVGL_UI_OP_CLEAR_FLAG:
+                lv_obj_clear_flag(obj, (lv_obj_flag_t)op->value);
+                break;
+            case LVGL_UI_OP_REMOVE_STYLE_ALL:
+                lv_obj_remove_style_all(obj);
+                break;
+            case LVGL_UI_OP_FLEX_FLOW:
+                lv_obj_set_flex_flow(obj, (lv_flex_flow_t)op->arg);
+                break;
+            case LVGL_UI_OP_FLEX_ALIGN:
+                lv_obj_set_flex_align(obj, (lv_flex_align_t)op->arg, (lv_flex_align_t)op->x, (lv_flex_align_t)op->y);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return root;
+}
+
+// --- Object Name Index ---
+
+uint32_t lvgl_ui_hash_str(const char* name) {
+    uint32_t h = LVGL_UI_HASH_SEED;
+    while (*name) {
+        h = (h ^ (uint8_t)*name++) * LVGL_UI_HASH_PRIME;
+    }
+    return h;
+}
+
+// Inserts into a slot array without growing; returns false if no free slot
+static bool index_insert_slot(lvgl_ui_index_entry_t* slots, uint16_t capacity, const char* arena,
+                              uint32_t hash, uint32_t name_offset, lv_obj_t* obj, bool* replaced) {
+    uint16_t mask = capacity - 1;
+    for (uint16_t probe = 0; probe < capacity; probe++) {
+        lvgl_ui_index_entry_t* slot = &slots[(hash + probe) & mask];
+        if (!slot->obj) {
+            slot->hash = hash;
+            slot->name_offset = name_offset;
+            slot->obj = obj;
+            *replaced = false;
+            return true;
+        }
+        if (slot->hash == hash && strcmp(arena + slot->name_offset, arena + name_offset) == 0) {
+            slot->obj = obj;
+            *replaced = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool index_grow(lvgl_ui_index_t* index, uint16_t new_capacity) {
+    lvgl_ui_index_entry_t* slots = (lvgl_ui_index_entry_t*)calloc(new_capacity, sizeof(lvgl_ui_index_entry_t));
+    if (!slots) return false;
+
+    bool replaced;
+    for (uint16_t i = 0; i < index->capacity; i++) {
+        lvgl_ui_index_entry_t* old = &index->slots[i];
+        if (old->obj) {
+            index_insert_slot(slots, new_capacity, index->arena, old->hash, old->name_offset, old->obj, &replaced);
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = new_capacity;
+    return true;
+}
+
+bool lvgl_ui_index_reserve(lvgl_ui_index_t* index, uint16_t expected_count) {
+    if (!index) return false;
+    uint16_t capacity = LVGL_UI_INDEX_MIN_CAPACITY;
+    while (capacity < expected_count * 2) capacity <<= 1; // Keep load factor <= 0.5
+    return capacity <= index->capacity || index_grow(index, capacity);
+}
+
+bool lvgl_ui_index_add(lvgl_ui_index_t* index, uint32_t hash, const char* name, lv_obj_t* obj) {
+    if (!index || !name || !obj) return false;
+
+    if ((index->count + 1) * 2 > index->capacity) {
+        uint16_t capacity = index->capacity ? index->capacity * 2 : LVGL_UI_INDEX_MIN_CAPACITY;
+        if (!index_grow(index, capacity)) return false;
+    }
+
+    // Slots refer to names by offset, so the arena can move when it grows
+    size_t len = strlen(name) + 1;
+    if (index->arena_used + len > index->arena_capacity) {
+        uint32_t capacity = index->arena_capacity ? index->arena_capacity : LVGL_UI_ARENA_MIN_CAPACITY;
+        while (index->arena_used + len > capacity) capacity *= 2;
+        char* arena = (char*)realloc(index->arena, capacity);
+        if (!arena) return false;
+        index->arena = arena;
+        index->arena_capacity = capacity;
+    }
+    uint32_t name_offset = index->arena_used;
+    memcpy(index->arena + name_offset, name, len);
+
+    bool replaced;
+    if (!index_insert_slot(index->slots, index->capacity, index->arena, hash, name_offset, obj, &replaced)) {
+        return false; // Cannot happen below the load factor limit
+    }
+    if (replaced) {
+        Serial.printf("UI index: duplicate object name '%s', keeping the newest\n", name);
+    } else {
+        index->arena_used += len;
+        index->count++;
+    }
+    return true;
+}
+
+lv_obj_t* lvgl_ui_index_find(const lvgl_ui_index_t* index, uint32_t hash, const char* name) {
+    if (!index || !index->slots || !name) return NULL;
+
+    uint16_t mask = index->capacity - 1;
+    for (uint16_t probe = 0; probe < index->capacity; probe++) {
+        const lvgl_ui_index_entry_t* slot = &index->slots[(hash + probe) & mask];
+        if (!slot->obj) return NULL;
+        if (slot->hash == hash && strcmp(index->arena + slot->name_offset, name) == 0) {
+            return slot->obj;
         }
     }
     return NULL;
 }
 
+void lvgl_ui_index_free(lvgl_ui_index_t* index) {
+    if (!index) return;
+    free(index->slots);
+    free(index->arena);
+    memset(index, 0, sizeof(*index));
+}
@@ -1,6 +1,10 @@
 /*
  * LVGL XML Loader for loading UI from XML files.
- * Supports loading UI definitions created in LVGL Online Editor.
+ * Supports loading UI definitions created in LVGL Online Editor, and runs the
+ * precompiled widget-op streams generated from the same XML by
+ * tools/ui_compile.py (see ui/ui_screen_ops.h).
+ * Named objects are stored in a growable hash index whose names live in an
+ * arena owned by the index, looked up by FNV-1a hash (compile-time for literals).
  */
 
 #ifndef LVGL_XML_LOADER_H
@@ -13,34 +17,131 @@
 extern "C" {
 #endif
 
-// Structure to store object name to pointer mapping
+// 1 = build screens from the precompiled op streams, 0 = parse the embedded XML at boot
+#ifndef LVGL_UI_USE_COMPILED
+#define LVGL_UI_USE_COMPILED 1
+#endif
+
+#if LV_FONT_MONTSERRAT_48
+#define LVGL_UI_FONT_MONTSERRAT_48 (&lv_font_montserrat_48)
+#else
+#define LVGL_UI_FONT_MONTSERRAT_48 (&lv_font_montserrat_24)
+#endif
+
+// One slot of the object name index (empty when obj is NULL)
 typedef struct {
-    const char* name;
+    uint32_t hash;
+    uint32_t name_offset; // Offset of the NUL-terminated name in the arena
     lv_obj_t* obj;
-} lvgl_xml_obj_map_t;
+} lvgl_ui_index_entry_t;
+
+// Name -> object index for a loaded screen. Zero-initialize before first use.
+typedef struct {
+    lvgl_ui_index_entry_t* slots; // Open addressing, capacity is a power of two
+    uint16_t capacity;
+    uint16_t count;
+    char* arena;                  // Owned copies of all names
+    uint32_t arena_used;
+    uint32_t arena_capacity;
+} lvgl_ui_index_t;
+
+#define LVGL_UI_HASH_SEED  2166136261u // FNV-1a 32-bit offset basis
+#define LVGL_UI_HASH_PRIME 16777619u
+
+// Widget types for LVGL_UI_OP_BEGIN
+typedef enum {
+    LVGL_UI_OBJ,
+    LVGL_UI_LABEL,
+    LVGL_UI_BTN
+} lvgl_ui_widget_t;
+
+// Widget-op codes (one op per applied XML attribute)
+typedef enum {
+    LVGL_UI_OP_BEGIN,             // arg = widget type, ptr = name or NULL, value = name hash; becomes the current object
+    LVGL_UI_OP_END,               // Return to the parent object
+    LVGL_UI_OP_SIZE,              // x = width, y = height
+    LVGL_UI_OP_ALIGN,             // arg = lv_align_t, x/y = offsets
+    LVGL_UI_OP_BG_COLOR,          // value = 0xRRGGBB
+    LVGL_UI_OP_TEXT_COLOR,        // value = 0xRRGGBB
+    LVGL_UI_OP_FONT,              // ptr = const lv_font_t*
+    LVGL_UI_OP_TEXT,              // ptr = text, arg = 1 to center in parent
+    LVGL_UI_OP_ADD_FLAG,          // value = lv_obj_flag_t
+    LVGL_UI_OP_CLEAR_FLAG,        // value = lv_obj_flag_t
+    LVGL_UI_OP_REMOVE_STYLE_ALL,
+    LVGL_UI_OP_FLEX_FLOW,         // arg = lv_flex_flow_t
+    LVGL_UI_OP_FLEX_ALIGN         // arg/x/y = main/cross/track lv_flex_align_t
+} lvgl_ui_opcode_t;
+
+// One precompiled op, generated by tools/ui_compile.py
+typedef struct {
+    uint8_t op;
+    uint8_t arg;
+    int16_t x;
+    int16_t y;
+    const void* ptr;
+    uint32_t value;
+} lvgl_ui_op_t;
 
 /**
  * Load an LVGL screen from XML string
  * @param xml_string The XML string containing the UI definition
  * @param parent Parent object (NULL for screen)
- * @param obj_map Array to store name-to-object mappings
- * @param obj_map_size Size of obj_map array
+ * @param index Index that receives the named objects (may be NULL)
  * @return Created screen/object, or NULL on error
  */
-lv_obj_t* lvgl_xml_load_from_string(const char* xml_string, lv_obj_t* parent, 
-                                     lvgl_xml_obj_map_t* obj_map, uint16_t obj_map_size);
+lv_obj_t* lvgl_xml_load_from_string(const char* xml_string, lv_obj_t* parent, lvgl_ui_index_t* index);
+
+/**
+ * Build an LVGL object tree from a precompiled op stream
+ * @param ops Op stream (e.g. shot_stopper_screen_ops from ui/ui_screen_ops.h)
+ * @param op_count Number of ops
+ * @param parent Parent object (NULL for screen)
+ * @param index Index that receives the named objects (may be NULL)
+ * @return Created root object, or NULL on error
+ */
+lv_obj_t* lvgl_ui_load_ops(const lvgl_ui_op_t* ops, uint16_t op_count, lv_obj_t* parent, lvgl_ui_index_t* index);
 
 /**
- * Find an object by name from the object map
- * @param obj_map Object map array
- * @param obj_map_size Size of obj_map array
- * @param name Name of the object to find
+ * FNV-1a hash of a name at runtime (same value as lvgl_ui_hash())
+ */
+uint32_t lvgl_ui_hash_str(const char* name);
+
+/**
+ * Pre-size an index for an expected number of objects
+ * @return false if allocation failed
+ */
+bool lvgl_ui_index_reserve(lvgl_ui_index_t* index, uint16_t expected_count);
+
+/**
+ * Add (or replace) a named object. The name is copied into the index arena.
+ * @return false if allocation failed
+ */
+bool lvgl_ui_index_add(lvgl_ui_index_t* index, uint32_t hash, const char* name, lv_obj_t* obj);
+
+/**
+ * Find an object by name hash; the name is compared to rule out collisions
  * @return Object pointer or NULL if not found
  */
-lv_obj_t* lvgl_xml_find_object(lvgl_xml_obj_map_t* obj_map, uint16_t obj_map_size, const char* name);
+lv_obj_t* lvgl_ui_index_find(const lvgl_ui_index_t* index, uint32_t hash, const char* name);
+
+/**
+ * Release the index slots and arena (the objects themselves are not touched)
+ */
+void lvgl_ui_index_free(lvgl_ui_index_t* index);
 
 #ifdef __cplusplus
 }
+
+#include <type_traits>
+
+// Compile-time FNV-1a hash of a name
+constexpr uint32_t lvgl_ui_hash(const char* s, uint32_t h = LVGL_UI_HASH_SEED) {
+    return *s ? lvgl_ui_hash(s + 1, (h ^ (uint8_t)*s) * LVGL_UI_HASH_PRIME) : h;
+}
+
+// Look up an object by a string literal; the hash is folded at compile time
+#define LVGL_UI_FIND(index, literal) \
+    lvgl_ui_index_find((index), std::integral_constant<uint32_t, lvgl_ui_hash(literal)>::value, (literal))
 #endif
 
 #endif // LVGL_XML_LOADER_H
@@ -0,0 +1,81 @@
+/*
+ * Minimal serial command console.
+ *
+ * Commands live in a fixed table and take no arguments; the task polls
+ * Serial at CONSOLE_POLL_MS, so it costs nothing while nobody is typing.
+ */
+
+#include <Arduino.h>
+#include "serial_console.h"
+#include "task_config.h"
+
+#define CONSOLE_MAX_COMMANDS 12
+#define CONSOLE_LINE_MAX 32
+#define CONSOLE_POLL_MS 100
+
+typedef struct {
+    const char* name;
+    const char* help;
+    console_cmd_fn_t fn;
+} console_cmd_t;
+
+static console_cmd_t commands[CONSOLE_MAX_COMMANDS];
+static int command_count = 0;
+static portMUX_TYPE console_mux = portMUX_INITIALIZER_UNLOCKED;
+
+bool serial_console_register(const char* name, const char* help, console_cmd_fn_t fn) {
+    portENTER_CRITICAL(&console_mux);
+    bool ok = command_count < CONSOLE_MAX_COMMANDS;
+    if (ok) {
+        commands[command_count++] = {name, help, fn};
+    }
+    portEXIT_CRITICAL(&console_mux);
+    return ok;
+}
+
+static void console_help() {
+    Serial.println("Commands:");
+    for (int i = 0; i < command_count; i++) {
+        Serial.printf("  %-8s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+static void console_run(const char* line) {
+    if (line[0] == '\0') return;
+    if (strcmp(line, "help") == 0) {
+        console_help();
+        return;
+    }
+    for (int i = 0; i < command_count; i++) {
+        if (strcmp(line, commands[i].name) == 0) {
+            commands[i].fn();
+            return;
+        }
+    }
+    Serial.printf("Unknown command '%s'. Type 'help'.\n", line);
+}
+
+static void console_task(void* arg) {
+    char line[CONSOLE_LINE_MAX];
+    size_t len = 0;
+    while (true) {
+        while (Serial.available() > 0) {
+            int c = Serial.read();
+            if (c == '\r' || c == '\n') {
+                line[len] = '\0';
+                console_run(line);
+                len = 0;
+            } else if (len < sizeof(line) - 1) {
+                line[len++] = (char)c;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONSOLE_POLL_MS));
+    }
+}
+
+void serial_console_init() {
+    if (xTaskCreatePinnedToCore(console_task, "Console", CONSOLE_TASK_STACK, NULL,
+                                CONSOLE_TASK_PRIORITY, NULL, CONSOLE_TASK_CORE) != pdPASS) {
+        Serial.println("!!! Failed to create console task !!!");
+    }
+}
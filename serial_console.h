@@ -0,0 +1,17 @@
+/*
+ * Minimal serial command console.
+ * A low-priority task reads lines from Serial and runs the matching command
+ * (e.g. "ble" dumps the BLE statistics). "help" lists what is registered.
+ */
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+typedef void (*console_cmd_fn_t)();
+
+// Registers a command; call before or after serial_console_init(). Names are matched exactly.
+bool serial_console_register(const char* name, const char* help, console_cmd_fn_t fn);
+
+// Starts the console task
+void serial_console_init();
+
+#endif // SERIAL_CONSOLE_H
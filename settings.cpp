@@ -0,0 +1,296 @@
+/*
+ * Persistent settings store.
+ *
+ * Talks to NVS directly (nvs_open/nvs_commit) in the same "shotStopper"
+ * namespace and with the same key types Preferences used, so values saved
+ * by earlier firmware load unchanged. The NVS handle is only open while a
+ * load or commit runs. A failed commit leaves its keys dirty for the next one.
+ */
+
+#include <Arduino.h>
+#include <nvs.h>
+#include <string.h>
+#include "settings.h"
+#include "app_log.h"
+#include "task_config.h"
+
+#define SETTINGS_NAMESPACE "shotStopper"
+#define SETTINGS_QUIET_MS 3000   // Commit once changes have stopped for this long
+#define SETTINGS_VALUE_MAX 32    // Largest string (with NUL) or blob
+
+typedef enum {
+    SETTING_TYPE_I8,
+    SETTING_TYPE_U8,
+    SETTING_TYPE_STR,
+    SETTING_TYPE_BLOB,
+} setting_type_t;
+
+typedef struct {
+    const char* key; // NVS key, max 15 chars
+    setting_type_t type;
+} setting_def_t;
+
+// Indexed by setting_id_t
+static const setting_def_t SETTING_DEFS[SETTING_COUNT] = {
+    {"p1", SETTING_TYPE_I8},
+    {"p2", SETTING_TYPE_I8},
+    {"p3", SETTING_TYPE_I8},
+    {"ble_addr", SETTING_TYPE_STR},
+    {"ble_atype", SETTING_TYPE_U8},
+    {"ble_gatt", SETTING_TYPE_BLOB},
+};
+
+typedef struct {
+    uint8_t data[SETTINGS_VALUE_MAX];
+    uint8_t len;  // Bytes in data (strings include the NUL)
+    bool present;
+} setting_value_t;
+
+static setting_value_t shadow[SETTING_COUNT];
+static uint32_t dirty_mask = 0;
+static portMUX_TYPE settings_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t writer_task = NULL;
+static volatile bool flush_requested = false;
+static unsigned long commits = 0;
+
+static bool valid_id(setting_id_t id, setting_type_t type) {
+    return (unsigned)id < SETTING_COUNT && SETTING_DEFS[id].type == type;
+}
+
+// Stores a value in the shadow; marks it dirty only if it differs
+static void store(setting_id_t id, const void* data, size_t len, bool present) {
+    if (len > SETTINGS_VALUE_MAX) {
+        LOG_E("Setting %s too large (%u bytes).", SETTING_DEFS[id].key, (unsigned)len);
+        return;
+    }
+    bool changed;
+    portENTER_CRITICAL(&settings_mux);
+    setting_value_t* v = &shadow[id];
+    changed = v->present != present ||
+              (present && (v->len != len || memcmp(v->data, data, len) != 0));
+    if (changed) {
+        v->present = present;
+        v->len = present ? len : 0;
+        if (present) memcpy(v->data, data, len);
+        dirty_mask |= 1UL << id;
+    }
+    portEXIT_CRITICAL(&settings_mux);
+
+    if (changed && writer_task) {
+        xTaskNotifyGive(writer_task); // Restarts the quiet period
+    }
+}
+
+// Copies a shadow value out; returns false if unset
+static bool load_value(setting_id_t id, void* buf, size_t len, size_t* stored_len) {
+    portENTER_CRITICAL(&settings_mux);
+    const setting_value_t* v = &shadow[id];
+    bool present = v->present;
+    size_t n = v->len;
+    if (present) memcpy(buf, v->data, n < len ? n : len);
+    portEXIT_CRITICAL(&settings_mux);
+    if (stored_len) *stored_len = present ? n : 0;
+    return present;
+}
+
+// --- Load ---
+
+static void settings_load_all() {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        LOG_W("No saved settings, using defaults.");
+        return;
+    }
+    if (err != ESP_OK) {
+        LOG_E("Failed to open settings (err 0x%x), using defaults.", err);
+        return;
+    }
+
+    int loaded = 0;
+    for (int id = 0; id < SETTING_COUNT; id++) {
+        setting_value_t* v = &shadow[id];
+        size_t len = SETTINGS_VALUE_MAX;
+        switch (SETTING_DEFS[id].type) {
+            case SETTING_TYPE_I8:
+                err = nvs_get_i8(handle, SETTING_DEFS[id].key, (int8_t*)v->data);
+                len = 1;
+                break;
+            case SETTING_TYPE_U8:
+                err = nvs_get_u8(handle, SETTING_DEFS[id].key, v->data);
+                len = 1;
+                break;
+            case SETTING_TYPE_STR:
+                err = nvs_get_str(handle, SETTING_DEFS[id].key, (char*)v->data, &len);
+                break;
+            case SETTING_TYPE_BLOB:
+                err = nvs_get_blob(handle, SETTING_DEFS[id].key, v->data, &len);
+                break;
+        }
+        v->present = err == ESP_OK;
+        v->len = v->present ? len : 0;
+        if (v->present) loaded++;
+        else if (err != ESP_ERR_NVS_NOT_FOUND) LOG_W("Setting %s unreadable (err 0x%x).", SETTING_DEFS[id].key, err);
+    }
+    nvs_close(handle);
+    LOG_I("Loaded %d of %d settings.", loaded, SETTING_COUNT);
+}
+
+// --- Commit ---
+
+static void settings_commit() {
+    setting_value_t pending[SETTING_COUNT];
+    portENTER_CRITICAL(&settings_mux);
+    uint32_t mask = dirty_mask;
+    for (int id = 0; id < SETTING_COUNT; id++) {
+        if (mask & (1UL << id)) pending[id] = shadow[id];
+    }
+    dirty_mask = 0;
+    portEXIT_CRITICAL(&settings_mux);
+    if (mask == 0) return;
+
+    uint32_t failed = 0;
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        failed = mask;
+    } else {
+        for (int id = 0; id < SETTING_COUNT; id++) {
+            if (!(mask & (1UL << id))) continue;
+            const setting_value_t* v = &pending[id];
+            const char* key = SETTING_DEFS[id].key;
+            if (!v->present) {
+                err = nvs_erase_key(handle, key);
+                if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+            } else {
+                switch (SETTING_DEFS[id].type) {
+                    case SETTING_TYPE_I8:   err = nvs_set_i8(handle, key, (int8_t)v->data[0]); break;
+                    case SETTING_TYPE_U8:   err = nvs_set_u8(handle, key, v->data[0]); break;
+                    case SETTING_TYPE_STR:  err = nvs_set_str(handle, key, (const char*)v->data); break;
+                    case SETTING_TYPE_BLOB: err = nvs_set_blob(handle, key, v->data, v->len); break;
+                }
+            }
+            if (err != ESP_OK) failed |= 1UL << id;
+        }
+        err = nvs_commit(handle);
+        if (err != ESP_OK) failed = mask;
+        nvs_close(handle);
+    }
+
+    if (failed) {
+        portENTER_CRITICAL(&settings_mux);
+        dirty_mask |= failed; // Retried with the next change or flush
+        portEXIT_CRITICAL(&settings_mux);
+        LOG_E("Settings commit failed (err 0x%x, keys 0x%lx).", err, (unsigned long)failed);
+    } else {
+        commits++;
+        LOG_I("Committed %d setting(s) to NVS.", __builtin_popcount(mask));
+    }
+}
+
+// Waits for the first change, then for SETTINGS_QUIET_MS without another one
+static void settings_task(void* arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!flush_requested && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_QUIET_MS)) > 0) {
+        }
+        flush_requested = false;
+        settings_commit();
+    }
+}
+
+// --- Public API ---
+
+void settings_init() {
+    if (writer_task) return;
+    settings_load_all();
+    if (xTaskCreatePinnedToCore(settings_task, "Settings", SETTINGS_TASK_STACK, NULL,
+                                SETTINGS_TASK_PRIORITY, &writer_task, SETTINGS_TASK_CORE) != pdPASS) {
+        LOG_E("!!! Failed to create settings task !!!");
+        writer_task = NULL;
+    }
+}
+
+bool settings_is_set(setting_id_t id) {
+    if ((unsigned)id >= SETTING_COUNT) return false;
+    portENTER_CRITICAL(&settings_mux);
+    bool present = shadow[id].present;
+    portEXIT_CRITICAL(&settings_mux);
+    return present;
+}
+
+int8_t settings_get_i8(setting_id_t id, int8_t def) {
+    int8_t value;
+    if (!valid_id(id, SETTING_TYPE_I8) || !load_value(id, &value, 1, NULL)) return def;
+    return value;
+}
+
+void settings_set_i8(setting_id_t id, int8_t value) {
+    if (valid_id(id, SETTING_TYPE_I8)) store(id, &value, 1, true);
+}
+
+uint8_t settings_get_u8(setting_id_t id, uint8_t def) {
+    uint8_t value;
+    if (!valid_id(id, SETTING_TYPE_U8) || !load_value(id, &value, 1, NULL)) return def;
+    return value;
+}
+
+void settings_set_u8(setting_id_t id, uint8_t value) {
+    if (valid_id(id, SETTING_TYPE_U8)) store(id, &value, 1, true);
+}
+
+bool settings_get_str(setting_id_t id, char* buf, size_t len) {
+    if (len == 0) return false;
+    buf[0] = '\0';
+    if (!valid_id(id, SETTING_TYPE_STR) || !load_value(id, buf, len, NULL)) return false;
+    buf[len - 1] = '\0'; // Truncated copy
+    return true;
+}
+
+void settings_set_str(setting_id_t id, const char* value) {
+    if (valid_id(id, SETTING_TYPE_STR)) store(id, value, strlen(value) + 1, true);
+}
+
+size_t settings_get_blob(setting_id_t id, void* buf, size_t len) {
+    size_t stored = 0;
+    if (!valid_id(id, SETTING_TYPE_BLOB)) return 0;
+    load_value(id, buf, len, &stored);
+    return stored;
+}
+
+void settings_set_blob(setting_id_t id, const void* data, size_t len) {
+    if (valid_id(id, SETTING_TYPE_BLOB)) store(id, data, len, true);
+}
+
+void settings_erase(setting_id_t id) {
+    if ((unsigned)id < SETTING_COUNT) store(id, NULL, 0, false);
+}
+
+void settings_flush() {
+    if (writer_task == NULL) return;
+    flush_requested = true;
+    xTaskNotifyGive(writer_task);
+}
+
+void settings_dump() {
+    portENTER_CRITICAL(&settings_mux);
+    setting_value_t copy[SETTING_COUNT];
+    memcpy(copy, shadow, sizeof(copy));
+    uint32_t mask = dirty_mask;
+    portEXIT_CRITICAL(&settings_mux);
+
+    Serial.printf("[%lu] Settings (%lu commits since boot):\n", millis(), commits);
+    for (int id = 0; id < SETTING_COUNT; id++) {
+        const setting_value_t* v = &copy[id];
+        Serial.printf("  %-10s %s", SETTING_DEFS[id].key, v->present ? "" : "(unset)");
+        if (v->present) {
+            switch (SETTING_DEFS[id].type) {
+                case SETTING_TYPE_I8:   Serial.printf("%d", (int8_t)v->data[0]); break;
+                case SETTING_TYPE_U8:   Serial.printf("%u", v->data[0]); break;
+                case SETTING_TYPE_STR:  Serial.printf("\"%s\"", (const char*)v->data); break;
+                case SETTING_TYPE_BLOB: Serial.printf("%u bytes", v->len); break;
+            }
+        }
+        Serial.printf("%s\n", (mask & (1UL << id)) ? " (pending)" : "");
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Persistent settings store.
+ *
+ * Every persisted key lives in a RAM shadow that is loaded from NVS in one
+ * pass at boot. Setters only update the shadow and mark the key dirty; a
+ * low-priority writer task commits all dirty keys in a single NVS
+ * transaction once no change has arrived for SETTINGS_QUIET_MS, or right
+ * away when settings_flush() is called (e.g. before the display sleeps).
+ * Setting a key to the value it already has costs nothing. Getters and
+ * setters are safe from any task and never touch flash.
+ */
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstdint>
+#include <cstddef>
+
+typedef enum {
+    SETTING_PRESET_1,   // i8, grams
+    SETTING_PRESET_2,
+    SETTING_PRESET_3,
+    SETTING_PEER_ADDR,  // string, last good stopper address
+    SETTING_PEER_TYPE,  // u8, BLE address type of SETTING_PEER_ADDR
+    SETTING_GATT_CACHE, // blob, cached characteristic handles
+    SETTING_COUNT
+} setting_id_t;
+
+// Loads every key and starts the writer task. Call before anything reads a setting.
+void settings_init();
+
+// true if the key has a stored (or pending) value
+bool settings_is_set(setting_id_t id);
+
+int8_t settings_get_i8(setting_id_t id, int8_t def);
+void settings_set_i8(setting_id_t id, int8_t value);
+uint8_t settings_get_u8(setting_id_t id, uint8_t def);
+void settings_set_u8(setting_id_t id, uint8_t value);
+
+// Copies the string into buf; false (and buf = "") if unset
+bool settings_get_str(setting_id_t id, char* buf, size_t len);
+void settings_set_str(setting_id_t id, const char* value);
+
+// Copies up to len bytes; returns the stored length, 0 if unset
+size_t settings_get_blob(setting_id_t id, void* buf, size_t len);
+void settings_set_blob(setting_id_t id, const void* data, size_t len);
+
+// Removes the key (from flash on the next commit)
+void settings_erase(setting_id_t id);
+
+// Commits pending changes now instead of after the quiet period. Returns immediately.
+void settings_flush();
+
+// Logs every key, its value size and whether it is waiting to be committed
+void settings_dump();
+
+#endif // SETTINGS_H
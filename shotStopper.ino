@@ -1,15 +1,18 @@
 /*
  * Main application file for the ESP32-S3 Espresso Shot Stopper Controller.
- * This file is now simplified. All initialization logic has been moved to app_init()
- * to ensure correct setup order and task management. The main loop is empty because
- * all operations are now handled by their own FreeRTOS tasks.
+ * setup() only calls app_init(), which owns the setup order and starts the
+ * FreeRTOS tasks. The main loop is empty because all work runs on those tasks.
  */
 
 #include <Arduino.h>
 #include "app.h" // Include the new main application header
+#include "boot_trace.h"
+#include "app_log.h"
 
 void setup() {
+  boot_trace_mark(BOOT_MARK_SETUP);
   Serial.begin(115200);
+  app_log_init();
   delay(1000); // Give serial monitor time to connect
   Serial.println("--- Shot Stopper Controller ---");
   
@@ -0,0 +1,226 @@
+/*
+ * Shot session recorder.
+ *
+ * Flash format (NVS namespace "shotlog"): key "seq" holds the next session
+ * number, keys "s0".."s9" hold shot_record_t blobs in slot seq % 10. A record
+ * is an 8-byte header followed by `count` 4-byte events, each stored as the
+ * time before the end of the shot in 0.1 s, its kind and the weight in grams.
+ * Only the used events are written, so a typical record is a few dozen bytes.
+ *
+ * Upload format (one HA text sensor update per shot, under 255 chars):
+ *   "#12 28.5s 36g: -95.2w36 -30.1n38"
+ * = session 12, 28.5 s shot, 36 g target at the end; 95.2 s before the end a
+ *   36 g write was verified ('w'), 30.1 s before it the stopper reported 38 g ('n').
+ */
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <nvs.h>
+#include <math.h>
+#include "shot_session.h"
+#include "ble_client.h" // target_weight
+#include "app_log.h"
+
+#define SHOT_RING_EVENTS 256             // Recent events kept in RAM
+#define SHOT_HISTORY_SESSIONS 10         // Sessions kept in flash
+#define SHOT_SESSION_EVENTS 16           // Newest events packed into one session
+#define SHOT_SESSION_WINDOW_MS 600000    // Events more than 10 min before the shot end are not part of it
+#define SHOT_RECORD_VERSION 1
+#define SHOT_NVS_NAMESPACE "shotlog"
+
+typedef struct {
+    uint32_t t_ms;
+    uint8_t kind;
+    int8_t value;
+} shot_ring_entry_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t dt_ds; // Before the end of the shot, 0.1 s
+    uint8_t kind;
+    int8_t value;
+} shot_record_event_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t count;        // Used entries in events[]
+    uint16_t seq;
+    uint16_t duration_ds; // HA shot duration, 0.1 s
+    int8_t target_g;      // Target weight when the shot ended
+    uint8_t reserved;
+    shot_record_event_t events[SHOT_SESSION_EVENTS];
+} shot_record_t;
+
+#define SHOT_RECORD_HEADER_LEN offsetof(shot_record_t, events)
+
+static shot_ring_entry_t* ring = NULL;
+static uint32_t ring_head = 0;          // Total events recorded; next slot is ring_head % SHOT_RING_EVENTS
+static uint32_t session_start_ms = 0;   // Events before this belong to the previous shot
+static portMUX_TYPE ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static shot_record_t history[SHOT_HISTORY_SESSIONS];
+static uint16_t next_seq = 0;
+static int32_t upload_seq = -1;         // Session waiting to be uploaded, -1 = none
+static portMUX_TYPE history_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t record_len(const shot_record_t* r) {
+    return SHOT_RECORD_HEADER_LEN + r->count * sizeof(shot_record_event_t);
+}
+
+static void slot_key(char* key, size_t len, uint16_t seq) {
+    snprintf(key, len, "s%u", (unsigned)(seq % SHOT_HISTORY_SESSIONS));
+}
+
+static void load_history() {
+    nvs_handle_t handle;
+    if (nvs_open(SHOT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return; // Nothing saved yet
+    nvs_get_u16(handle, "seq", &next_seq);
+    int loaded = 0;
+    for (int slot = 0; slot < SHOT_HISTORY_SESSIONS; slot++) {
+        char key[4];
+        slot_key(key, sizeof(key), slot);
+        shot_record_t r = {};
+        size_t len = sizeof(r);
+        if (nvs_get_blob(handle, key, &r, &len) != ESP_OK) continue;
+        if (r.version != SHOT_RECORD_VERSION || r.count > SHOT_SESSION_EVENTS || len != record_len(&r)) continue;
+        history[r.seq % SHOT_HISTORY_SESSIONS] = r;
+        loaded++;
+    }
+    nvs_close(handle);
+    LOG_I("Loaded %d shot session(s), next is #%u.", loaded, next_seq);
+}
+
+static bool save_record(const shot_record_t* r) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SHOT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        char key[4];
+        slot_key(key, sizeof(key), r->seq);
+        err = nvs_set_blob(handle, key, r, record_len(r));
+        if (err == ESP_OK) err = nvs_set_u16(handle, "seq", next_seq);
+        if (err == ESP_OK) err = nvs_commit(handle); // One commit per shot
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) LOG_E("Failed to save shot session #%u (err 0x%x).", r->seq, err);
+    return err == ESP_OK;
+}
+
+void shot_session_init() {
+    if (ring) return;
+    ring = (shot_ring_entry_t*)heap_caps_calloc(SHOT_RING_EVENTS, sizeof(shot_ring_entry_t), MALLOC_CAP_SPIRAM);
+    if (ring == NULL) {
+        ring = (shot_ring_entry_t*)heap_caps_calloc(SHOT_RING_EVENTS, sizeof(shot_ring_entry_t), MALLOC_CAP_8BIT);
+    }
+    if (ring == NULL) {
+        LOG_E("!!! Failed to allocate shot session ring !!!");
+    }
+    load_history();
+}
+
+void shot_session_record(shot_event_kind_t kind, int8_t value) {
+    if (ring == NULL) return;
+    portENTER_CRITICAL(&ring_mux);
+    shot_ring_entry_t* e = &ring[ring_head % SHOT_RING_EVENTS];
+    e->t_ms = millis();
+    e->kind = (uint8_t)kind;
+    e->value = value;
+    ring_head++;
+    portEXIT_CRITICAL(&ring_mux);
+}
+
+void shot_session_end(float duration_s) {
+    uint32_t now = millis();
+    shot_record_t r = {};
+    r.version = SHOT_RECORD_VERSION;
+    r.target_g = target_weight;
+    float ds = roundf(duration_s * 10.0f);
+    r.duration_ds = ds < 0 ? 0 : ds > 65535 ? 65535 : (uint16_t)ds;
+
+    // Newest events of this session, copied out newest first
+    shot_ring_entry_t picked[SHOT_SESSION_EVENTS];
+    int n = 0;
+    if (ring) {
+        portENTER_CRITICAL(&ring_mux);
+        uint32_t available = ring_head < SHOT_RING_EVENTS ? ring_head : SHOT_RING_EVENTS;
+        for (uint32_t i = 0; i < available && n < SHOT_SESSION_EVENTS; i++) {
+            const shot_ring_entry_t* e = &ring[(ring_head - 1 - i) % SHOT_RING_EVENTS];
+            if ((int32_t)(e->t_ms - session_start_ms) < 0 || now - e->t_ms > SHOT_SESSION_WINDOW_MS) break;
+            picked[n++] = *e;
+        }
+        portEXIT_CRITICAL(&ring_mux);
+    }
+    for (int i = 0; i < n; i++) {
+        const shot_ring_entry_t* e = &picked[n - 1 - i]; // Chronological
+        uint32_t dt = (now - e->t_ms) / 100;
+        r.events[i].dt_ds = dt > 65535 ? 65535 : dt;
+        r.events[i].kind = e->kind;
+        r.events[i].value = e->value;
+    }
+    r.count = n;
+
+    portENTER_CRITICAL(&history_mux);
+    const shot_record_t* prev = next_seq > 0 ? &history[(uint16_t)(next_seq - 1) % SHOT_HISTORY_SESSIONS] : NULL;
+    bool repeat = n == 0 && prev && prev->version == SHOT_RECORD_VERSION && prev->duration_ds == r.duration_ds;
+    portEXIT_CRITICAL(&history_mux);
+    if (repeat) {
+        // HA re-sends the last value after a reconnect; nothing new happened
+        LOG_D("Ignoring repeated shot duration %.1fs.", duration_s);
+        return;
+    }
+
+    portENTER_CRITICAL(&history_mux);
+    r.seq = next_seq++;
+    history[r.seq % SHOT_HISTORY_SESSIONS] = r;
+    upload_seq = r.seq;
+    portEXIT_CRITICAL(&history_mux);
+    session_start_ms = now;
+
+    save_record(&r);
+    LOG_I("Shot session #%u closed: %.1fs, %dg, %d event(s).", r.seq, duration_s, r.target_g, n);
+}
+
+static void format_record(const shot_record_t* r, char* buf, size_t len) {
+    int pos = snprintf(buf, len, "#%u %.1fs %dg:", r->seq, r->duration_ds / 10.0f, r->target_g);
+    for (int i = 0; i < r->count && pos > 0 && (size_t)pos < len; i++) {
+        const shot_record_event_t* e = &r->events[i];
+        int w = snprintf(buf + pos, len - pos, " -%.1f%c%d", e->dt_ds / 10.0f,
+                         e->kind == SHOT_EVT_NOTIFIED ? 'n' : 'w', e->value);
+        if (w < 0 || (size_t)(pos + w) >= len) {
+            buf[pos] = '\0'; // Drop the partial event rather than cut it
+            break;
+        }
+        pos += w;
+    }
+}
+
+bool shot_session_format_pending(char* buf, size_t len, uint16_t* seq) {
+    shot_record_t r;
+    portENTER_CRITICAL(&history_mux);
+    bool pending = upload_seq >= 0;
+    if (pending) r = history[upload_seq % SHOT_HISTORY_SESSIONS];
+    portEXIT_CRITICAL(&history_mux);
+    if (!pending) return false;
+    format_record(&r, buf, len);
+    *seq = r.seq;
+    return true;
+}
+
+void shot_session_mark_uploaded(uint16_t seq) {
+    portENTER_CRITICAL(&history_mux);
+    if (upload_seq == seq) upload_seq = -1; // A newer shot may have replaced it meanwhile
+    portEXIT_CRITICAL(&history_mux);
+}
+
+void shot_session_dump() {
+    char line[256];
+    Serial.printf("[%lu] Shot sessions (next #%u):\n", millis(), next_seq);
+    for (int i = SHOT_HISTORY_SESSIONS; i > 0; i--) {
+        if (next_seq < i) continue;
+        shot_record_t r;
+        portENTER_CRITICAL(&history_mux);
+        r = history[(uint16_t)(next_seq - i) % SHOT_HISTORY_SESSIONS];
+        portEXIT_CRITICAL(&history_mux);
+        if (r.version != SHOT_RECORD_VERSION) continue;
+        format_record(&r, line, sizeof(line));
+        Serial.printf("  %s\n", line);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * Shot session recorder.
+ *
+ * Verified target weight writes, weight notifications from the stopper and
+ * the shot duration reported by Home Assistant are recorded with timestamps
+ * into a fixed-size ring (PSRAM when available, allocated once at init, so
+ * recording never allocates). When HA reports a shot duration the session
+ * is closed: the events leading up to it are packed into a compact record,
+ * the last SHOT_HISTORY_SESSIONS records are kept in flash, and the session
+ * is uploaded to HA as one text message by the network task.
+ */
+#ifndef SHOT_SESSION_H
+#define SHOT_SESSION_H
+
+#include <cstdint>
+#include <cstddef>
+
+typedef enum {
+    SHOT_EVT_TARGET_WRITTEN, // value: grams, verified on the stopper
+    SHOT_EVT_NOTIFIED,       // value: grams, changed on the stopper itself
+} shot_event_kind_t;
+
+// Allocates the ring and loads the flash history. Call once, before BLE and HA start.
+void shot_session_init();
+
+// Records an event. Safe from any task, never blocks or allocates.
+void shot_session_record(shot_event_kind_t kind, int8_t value);
+
+// Closes the current session with HA's shot duration. Writes flash; call from the network task.
+void shot_session_end(float duration_s);
+
+// Formats the newest session not yet uploaded. Returns false if there is none.
+bool shot_session_format_pending(char* buf, size_t len, uint16_t* seq);
+void shot_session_mark_uploaded(uint16_t seq);
+
+// Logs the sessions kept in flash, oldest first
+void shot_session_dump();
+
+#endif // SHOT_SESSION_H
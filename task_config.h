@@ -0,0 +1,72 @@
+/*
+ * Task topology for the shotStopper controller.
+ *
+ * Every FreeRTOS task this firmware creates takes its core, priority and
+ * stack size from here, so the whole plan can be read (and tuned) in one place.
+ *
+ * Core 0 is the radio core: the BLE controller, Bluedroid and the Wi-Fi/LwIP
+ * tasks all live there, so the BLE worker and the network task join them.
+ * Core 1 is kept for the UI: LVGL rendering and the knob input task, so a BLE
+ * reconnect or an MQTT burst can't preempt a swipe animation.
+ * Priorities only compete within a core.
+ */
+
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#define TASK_CORE_RADIO 0
+#define TASK_CORE_UI    1
+
+// LVGL port task (lcd_bsp.c)
+#define LVGL_TASK_CORE      TASK_CORE_UI
+#define LVGL_TASK_PRIORITY  2
+#define LVGL_TASK_STACK     (8 * 1024)
+
+// Knob PCNT settle task (bidi_switch_knob.c); short bursts, above LVGL so detents aren't delayed by a redraw
+#define KNOB_TASK_CORE      TASK_CORE_UI
+#define KNOB_TASK_PRIORITY  6
+#define KNOB_TASK_STACK     3072
+
+// BLE worker (ble_client.cpp); blocks on the Bluedroid tasks, so it runs next to them
+#define BLE_TASK_CORE       TASK_CORE_RADIO
+#define BLE_TASK_PRIORITY   5
+#define BLE_TASK_STACK      6144
+
+// Wi-Fi/MQTT state machine and mqtt.loop() (home_assistant.cpp)
+#define HA_TASK_CORE        TASK_CORE_RADIO
+#define HA_TASK_PRIORITY    3
+#define HA_TASK_STACK       6144
+
+// Log ring drain (app_log.cpp); lowest priority, it only moves text to the UART
+#define LOG_TASK_CORE     TASK_CORE_RADIO
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_STACK    2560
+
+// Serial command console (serial_console.cpp)
+#define CONSOLE_TASK_CORE     TASK_CORE_RADIO
+#define CONSOLE_TASK_PRIORITY 1
+#define CONSOLE_TASK_STACK    4096   // Commands print with floats
+
+// Heap/stack/LVGL memory collector (telemetry.cpp)
+#define TELEMETRY_TASK_CORE     TASK_CORE_RADIO
+#define TELEMETRY_TASK_PRIORITY 1
+#define TELEMETRY_TASK_STACK    3072
+
+// Battery ADC sampling (battery.cpp)
+#define BATTERY_TASK_CORE     TASK_CORE_RADIO
+#define BATTERY_TASK_PRIORITY 1
+#define BATTERY_TASK_STACK    3072
+
+// Settings writer (settings.cpp); batches NVS commits
+#define SETTINGS_TASK_CORE     TASK_CORE_RADIO
+#define SETTINGS_TASK_PRIORITY 1
+#define SETTINGS_TASK_STACK    3072
+
+// Per-task CPU report (task_stats.cpp)
+#define TASK_STATS_ENABLE    0       // 1 = log per-task CPU usage every TASK_STATS_PERIOD_MS
+#define TASK_STATS_PERIOD_MS 10000
+#define TASK_STATS_CORE      TASK_CORE_RADIO
+#define TASK_STATS_PRIORITY  1
+#define TASK_STATS_STACK     3072
+
+#endif // TASK_CONFIG_H
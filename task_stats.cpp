@@ -0,0 +1,98 @@
+/*
+ * Per-task CPU usage report.
+ *
+ * Samples uxTaskGetSystemState() and reports the run-time delta of every
+ * task since the previous sample as a percentage of total CPU time (both
+ * cores). Requires configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY
+ * in the FreeRTOS build; without them the report is compiled out.
+ */
+
+#include <Arduino.h>
+#include "task_stats.h"
+#include "task_config.h"
+
+#define TASK_STATS_MAX_TASKS 32 // Tasks tracked between samples
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+
+typedef struct {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_sample_t;
+
+static TaskStatus_t task_status[TASK_STATS_MAX_TASKS];
+static task_sample_t prev_samples[TASK_STATS_MAX_TASKS];
+static UBaseType_t prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE prev_total = 0;
+
+static configRUN_TIME_COUNTER_TYPE prev_runtime_of(TaskHandle_t handle) {
+    for (UBaseType_t i = 0; i < prev_count; i++) {
+        if (prev_samples[i].handle == handle) return prev_samples[i].runtime;
+    }
+    return 0; // New task: everything it has run counts toward this period
+}
+
+void task_stats_log() {
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, TASK_STATS_MAX_TASKS, &total);
+    if (count == 0) {
+        Serial.printf("[%lu] Task stats: more than %d tasks, report skipped\n", millis(), TASK_STATS_MAX_TASKS);
+        return;
+    }
+
+    // Run time is counted per core, so the budget for the period is elapsed time x cores
+    configRUN_TIME_COUNTER_TYPE elapsed = (total - prev_total) * portNUM_PROCESSORS;
+    if (prev_total != 0 && elapsed > 0) {
+        Serial.printf("[%lu] Task CPU over the last %lu ms:\n", millis(), (unsigned long)TASK_STATS_PERIOD_MS);
+        for (UBaseType_t i = 0; i < count; i++) {
+            const TaskStatus_t* t = &task_status[i];
+            configRUN_TIME_COUNTER_TYPE delta = t->ulRunTimeCounter - prev_runtime_of(t->xHandle);
+#if configTASKLIST_INCLUDE_COREID
+            int core = t->xCoreID == tskNO_AFFINITY ? -1 : (int)t->xCoreID;
+#else
+            int core = -1;
+#endif
+            Serial.printf("  %-16s core %2d prio %2u %5.1f%%\n", t->pcTaskName, core,
+                          (unsigned)t->uxCurrentPriority, delta * 100.0f / elapsed);
+        }
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        prev_samples[i].handle = task_status[i].xHandle;
+        prev_samples[i].runtime = task_status[i].ulRunTimeCounter;
+    }
+    prev_count = count;
+    prev_total = total;
+}
+
+static void task_stats_task(void* arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    task_stats_log(); // Baseline
+    while (true) {
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TASK_STATS_PERIOD_MS));
+        task_stats_log();
+    }
+}
+
+void task_stats_init() {
+#if TASK_STATS_ENABLE
+    if (xTaskCreatePinnedToCore(task_stats_task, "TaskStats", TASK_STATS_STACK, NULL,
+                                TASK_STATS_PRIORITY, NULL, TASK_STATS_CORE) != pdPASS) {
+        Serial.println("!!! Failed to create task stats task !!!");
+    }
+#endif
+}
+
+#else // No run-time stats in this FreeRTOS build
+
+void task_stats_log() {
+    Serial.printf("[%lu] Task stats need configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY\n", millis());
+}
+
+void task_stats_init() {
+#if TASK_STATS_ENABLE
+    task_stats_log();
+#endif
+}
+
+#endif
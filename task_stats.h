@@ -0,0 +1,17 @@
+/*
+ * Per-task CPU usage report.
+ * Logs each task's share of CPU time over the last period, with its core and
+ * priority, so the task topology in task_config.h can be checked on the device.
+ */
+
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+// Starts the periodic report if TASK_STATS_ENABLE is set and the FreeRTOS
+// build has run-time stats; otherwise does nothing.
+void task_stats_init();
+
+// Logs one report covering the time since the previous call.
+void task_stats_log();
+
+#endif // TASK_STATS_H
@@ -0,0 +1,294 @@
+/*
+ * Runtime memory telemetry.
+ *
+ * The RTC block carries a magic and a checksum; it is reset on power-on (RTC
+ * RAM content is undefined then) and whenever either check fails. Stack
+ * minima are matched to tasks by name, so they line up across resets even
+ * though task handles don't. Every update rewrites the checksum in the same
+ * telemetry_mux section, so a reset at any point finds a consistent block: the
+ * collector works on a copy and publishes it, and the LVGL task's minimum
+ * goes straight in.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include "telemetry.h"
+#include "task_config.h"
+
+#define TELEMETRY_RTC_MAGIC 0x54454C31 // "TEL1"
+#define TELEMETRY_MAX_TASKS 20         // Tasks tracked in RTC memory
+#define TELEMETRY_NAME_LEN 16          // configMAX_TASK_NAME_LEN on ESP-IDF
+#define TELEMETRY_PERIOD_MS 10000      // Collector interval
+
+typedef struct {
+    char name[TELEMETRY_NAME_LEN];
+    uint32_t min_stack; // Bytes
+} telemetry_task_min_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t resets;    // Boots since the last power-on
+    uint32_t internal_free_min;
+    uint32_t internal_largest_min;
+    uint32_t psram_free_min;
+    uint32_t dma_largest_min;
+    uint32_t lv_free_min;
+    telemetry_task_min_t tasks[TELEMETRY_MAX_TASKS];
+    uint32_t checksum;
+} telemetry_rtc_t;
+
+static RTC_NOINIT_ATTR telemetry_rtc_t rtc_minima;
+
+static telemetry_snapshot_t current = {};
+static uint32_t generation = 0;
+static esp_reset_reason_t reset_reason = ESP_RST_UNKNOWN;
+static portMUX_TYPE telemetry_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t task_status[TELEMETRY_MAX_TASKS];
+#else
+// Without the trace facility only our own tasks can be looked up
+static const char* const known_tasks[] = {
+    "LVGL_UI_Task", "BLE_Worker", "HA_Network", "knob_pcnt", "Console", "Telemetry", "TaskStats", "Log", "Battery", "Settings",
+};
+#endif
+
+static uint32_t rtc_checksum(const telemetry_rtc_t* r) {
+    const uint32_t* words = (const uint32_t*)r;
+    uint32_t sum = 0x9E3779B9;
+    for (size_t i = 0; i < offsetof(telemetry_rtc_t, checksum) / sizeof(uint32_t); i++) {
+        sum = (sum ^ words[i]) * 16777619u;
+    }
+    return sum;
+}
+
+static void rtc_reset() {
+    memset(&rtc_minima, 0, sizeof(rtc_minima));
+    rtc_minima.magic = TELEMETRY_RTC_MAGIC;
+    rtc_minima.internal_free_min = UINT32_MAX;
+    rtc_minima.internal_largest_min = UINT32_MAX;
+    rtc_minima.psram_free_min = UINT32_MAX;
+    rtc_minima.dma_largest_min = UINT32_MAX;
+    rtc_minima.lv_free_min = UINT32_MAX;
+}
+
+static const char* reset_reason_name(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "poweron";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int_wdt";
+        case ESP_RST_TASK_WDT:  return "task_wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        default:                return "other";
+    }
+}
+
+static inline void update_min(uint32_t* min, uint32_t value) {
+    if (value < *min) *min = value;
+}
+
+// Records a task's headroom against its slot in an RTC block image (by name)
+static void note_task_stack(telemetry_rtc_t* r, const char* name, uint32_t headroom) {
+    int free_slot = -1;
+    for (int i = 0; i < TELEMETRY_MAX_TASKS; i++) {
+        telemetry_task_min_t* t = &r->tasks[i];
+        if (t->name[0] == '\0') {
+            if (free_slot < 0) free_slot = i;
+        } else if (strncmp(t->name, name, TELEMETRY_NAME_LEN) == 0) {
+            update_min(&t->min_stack, headroom);
+            return;
+        }
+    }
+    if (free_slot >= 0) {
+        strncpy(r->tasks[free_slot].name, name, TELEMETRY_NAME_LEN - 1);
+        r->tasks[free_slot].min_stack = headroom;
+    }
+}
+
+// Samples every task's stack high-water mark (bytes on ESP-IDF). Returns the tightest one.
+static uint32_t sample_stacks(telemetry_rtc_t* r, char* tightest_name) {
+    uint32_t tightest = UINT32_MAX;
+#if configUSE_TRACE_FACILITY
+    UBaseType_t count = uxTaskGetSystemState(task_status, TELEMETRY_MAX_TASKS, NULL);
+    for (UBaseType_t i = 0; i < count; i++) {
+        uint32_t headroom = task_status[i].usStackHighWaterMark;
+        note_task_stack(r, task_status[i].pcTaskName, headroom);
+        if (headroom < tightest) {
+            tightest = headroom;
+            strncpy(tightest_name, task_status[i].pcTaskName, TELEMETRY_NAME_LEN - 1);
+        }
+    }
+#else
+    for (size_t i = 0; i < sizeof(known_tasks) / sizeof(known_tasks[0]); i++) {
+        TaskHandle_t handle = xTaskGetHandle(known_tasks[i]);
+        if (handle == NULL) continue;
+        uint32_t headroom = uxTaskGetStackHighWaterMark(handle);
+        note_task_stack(r, known_tasks[i], headroom);
+        if (headroom < tightest) {
+            tightest = headroom;
+            strncpy(tightest_name, known_tasks[i], TELEMETRY_NAME_LEN - 1);
+        }
+    }
+#endif
+    return tightest;
+}
+
+static void telemetry_collect() {
+    telemetry_snapshot_t s;
+    portENTER_CRITICAL(&telemetry_mux);
+    s = current; // Keeps the LVGL fields from telemetry_sample_lvgl()
+    portEXIT_CRITICAL(&telemetry_mux);
+
+    s.internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    s.internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    s.psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    s.psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    s.dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    s.dma_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    // Update a copy: the RTC block must never hold new minima under an old checksum
+    static telemetry_rtc_t next; // Static: too big for the collector's stack
+    portENTER_CRITICAL(&telemetry_mux);
+    next = rtc_minima;
+    portEXIT_CRITICAL(&telemetry_mux);
+
+    memset(s.min_stack_task, 0, sizeof(s.min_stack_task));
+    s.min_stack = sample_stacks(&next, s.min_stack_task);
+
+    // The allocator's own low-water mark also catches dips between samples
+    update_min(&next.internal_free_min, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    update_min(&next.internal_largest_min, s.internal_largest);
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+        update_min(&next.psram_free_min, heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+    }
+    update_min(&next.dma_largest_min, s.dma_largest);
+
+    portENTER_CRITICAL(&telemetry_mux);
+    update_min(&next.lv_free_min, rtc_minima.lv_free_min); // The LVGL task may have lowered it meanwhile
+    next.checksum = rtc_checksum(&next);
+    rtc_minima = next;
+    uint32_t lv_free = current.lv_free; // May have been updated meanwhile
+    uint8_t lv_used = current.lv_used_pct, lv_frag = current.lv_frag_pct;
+    current = s;
+    current.lv_free = lv_free;
+    current.lv_used_pct = lv_used;
+    current.lv_frag_pct = lv_frag;
+    generation++;
+    portEXIT_CRITICAL(&telemetry_mux);
+}
+
+void telemetry_sample_lvgl() {
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    portENTER_CRITICAL(&telemetry_mux);
+    current.lv_free = mon.free_size;
+    current.lv_used_pct = mon.used_pct;
+    current.lv_frag_pct = mon.frag_pct;
+    if (mon.free_size < rtc_minima.lv_free_min) {
+        // Straight into RTC: this runs right after screen builds, where a heap crash would hit
+        rtc_minima.lv_free_min = mon.free_size;
+        rtc_minima.checksum = rtc_checksum(&rtc_minima);
+    }
+    portEXIT_CRITICAL(&telemetry_mux);
+#endif
+}
+
+static void telemetry_task(void* arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        telemetry_collect();
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TELEMETRY_PERIOD_MS));
+    }
+}
+
+void telemetry_init() {
+    reset_reason = esp_reset_reason();
+    portENTER_CRITICAL(&telemetry_mux); // The LVGL task is already sampling
+    if (reset_reason == ESP_RST_POWERON || reset_reason == ESP_RST_BROWNOUT ||
+        rtc_minima.magic != TELEMETRY_RTC_MAGIC || rtc_minima.checksum != rtc_checksum(&rtc_minima)) {
+        rtc_reset();
+    } else {
+        rtc_minima.resets++;
+    }
+    rtc_minima.checksum = rtc_checksum(&rtc_minima);
+    portEXIT_CRITICAL(&telemetry_mux);
+    Serial.printf("[%lu] Telemetry: reset reason %s, %lu resets since power-on\n", millis(),
+                  reset_reason_name(reset_reason), (unsigned long)rtc_minima.resets);
+    if (rtc_minima.resets > 0) {
+        // What the previous run(s) got down to before resetting
+        char line[256];
+        telemetry_format_minima(line, sizeof(line));
+        Serial.printf("  Minimum ever: %s\n", line);
+        telemetry_format_stacks(line, sizeof(line));
+        Serial.printf("  Stack headroom (min ever, bytes): %s\n", line);
+    }
+
+    if (xTaskCreatePinnedToCore(telemetry_task, "Telemetry", TELEMETRY_TASK_STACK, NULL,
+                                TELEMETRY_TASK_PRIORITY, NULL, TELEMETRY_TASK_CORE) != pdPASS) {
+        Serial.println("!!! Failed to create telemetry task !!!");
+    }
+}
+
+telemetry_snapshot_t telemetry_get() {
+    portENTER_CRITICAL(&telemetry_mux);
+    telemetry_snapshot_t s = current;
+    portEXIT_CRITICAL(&telemetry_mux);
+    return s;
+}
+
+uint32_t telemetry_generation() {
+    return generation;
+}
+
+static unsigned long min_or_zero(uint32_t v) {
+    return v == UINT32_MAX ? 0 : v; // Not sampled yet
+}
+
+void telemetry_format_minima(char* buf, size_t len) {
+    snprintf(buf, len, "int=%lu int_blk=%lu psram=%lu dma_blk=%lu lv=%lu resets=%lu last=%s",
+             min_or_zero(rtc_minima.internal_free_min), min_or_zero(rtc_minima.internal_largest_min),
+             min_or_zero(rtc_minima.psram_free_min), min_or_zero(rtc_minima.dma_largest_min),
+             min_or_zero(rtc_minima.lv_free_min), (unsigned long)rtc_minima.resets,
+             reset_reason_name(reset_reason));
+}
+
+void telemetry_format_stacks(char* buf, size_t len) {
+    bool printed[TELEMETRY_MAX_TASKS] = {};
+    size_t used = 0;
+    buf[0] = '\0';
+    // Selection sort by headroom; the list is short and this runs once a minute at most
+    for (int n = 0; n < TELEMETRY_MAX_TASKS && used < len; n++) {
+        int best = -1;
+        for (int i = 0; i < TELEMETRY_MAX_TASKS; i++) {
+            if (printed[i] || rtc_minima.tasks[i].name[0] == '\0') continue;
+            if (best < 0 || rtc_minima.tasks[i].min_stack < rtc_minima.tasks[best].min_stack) best = i;
+        }
+        if (best < 0) break;
+        printed[best] = true;
+        int w = snprintf(buf + used, len - used, "%s%.*s=%lu", n ? " " : "", TELEMETRY_NAME_LEN,
+                         rtc_minima.tasks[best].name, (unsigned long)rtc_minima.tasks[best].min_stack);
+        if (w < 0) break;
+        used += (size_t)w;
+    }
+}
+
+void telemetry_dump() {
+    telemetry_snapshot_t s = telemetry_get();
+    char line[256];
+    Serial.printf("[%lu] Heap now: internal %lu (largest %lu), PSRAM %lu (largest %lu), DMA %lu (largest %lu)\n",
+                  millis(), (unsigned long)s.internal_free, (unsigned long)s.internal_largest,
+                  (unsigned long)s.psram_free, (unsigned long)s.psram_largest,
+                  (unsigned long)s.dma_free, (unsigned long)s.dma_largest);
+    Serial.printf("  LVGL heap: %lu free, %u%% used, %u%% fragmented\n",
+                  (unsigned long)s.lv_free, s.lv_used_pct, s.lv_frag_pct);
+    telemetry_format_minima(line, sizeof(line));
+    Serial.printf("  Minimum ever: %s\n", line);
+    telemetry_format_stacks(line, sizeof(line));
+    Serial.printf("  Stack headroom (min ever, bytes): %s\n", line);
+}
@@ -0,0 +1,51 @@
+/*
+ * Runtime memory telemetry.
+ *
+ * A low-priority collector samples every task's stack high-water mark, the
+ * free and largest-block sizes of internal, PSRAM and DMA-capable heap, and
+ * the LVGL heap (lv_mem_monitor, sampled on the LVGL task). Minimum-ever
+ * values are kept in RTC memory, so they survive panics and watchdog resets
+ * and the numbers from just before a crash can be read after it.
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstdint>
+#include <cstddef>
+
+typedef struct {
+    uint32_t internal_free;
+    uint32_t internal_largest;
+    uint32_t psram_free;
+    uint32_t psram_largest;
+    uint32_t dma_free;
+    uint32_t dma_largest;
+    uint32_t lv_free;          // LVGL heap, 0 if not using the builtin allocator
+    uint8_t lv_used_pct;
+    uint8_t lv_frag_pct;
+    uint32_t min_stack;        // Smallest stack headroom of any task, bytes
+    char min_stack_task[16];
+} telemetry_snapshot_t;
+
+// Restores (or resets, after power-on) the RTC minima and starts the collector
+void telemetry_init();
+
+// Samples the LVGL heap. Call from LVGL context only.
+void telemetry_sample_lvgl();
+
+// Latest sample (current values, not minima)
+telemetry_snapshot_t telemetry_get();
+
+// Minimum-ever heap values, reset count and last reset reason, on one line
+void telemetry_format_minima(char* buf, size_t len);
+
+// "task=bytes ..." minimum-ever stack headroom per task, smallest first
+void telemetry_format_stacks(char* buf, size_t len);
+
+// Increments whenever a new sample is taken, for change detection
+uint32_t telemetry_generation();
+
+// Logs current values and minima
+void telemetry_dump();
+
+#endif // TELEMETRY_H
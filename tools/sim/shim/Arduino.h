@@ -0,0 +1,46 @@
+/*
+ * Host shim: the slice of the Arduino core the simulated modules use.
+ * millis() follows the simulator's virtual clock, so logs and timeouts are
+ * reproducible from run to run.
+ */
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long millis(void);
+void delay(uint32_t ms); // Advances the virtual clock
+
+#ifdef __cplusplus
+}
+
+class SimSerial {
+public:
+    void print(const char* s) { fputs(s, stdout); }
+    void println(const char* s = "") { puts(s); }
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    size_t write(const uint8_t* data, size_t len) { return fwrite(data, 1, len, stdout); }
+};
+
+extern SimSerial Serial;
+#endif
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,19 @@
+/*
+ * Host shim: esp_timer_get_time() on the simulator's virtual clock.
+ */
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_ESP_TIMER_H
@@ -0,0 +1,31 @@
+/*
+ * Host shim: FreeRTOS software timers on the simulator's virtual clock.
+ * Callbacks run from sim_timers_run(), called by the benchmark loop.
+ */
+#ifndef SIM_FREERTOS_TIMERS_H
+#define SIM_FREERTOS_TIMERS_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_timer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+
+// Fires every timer that is due at the current virtual time
+void sim_timers_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_FREERTOS_TIMERS_H
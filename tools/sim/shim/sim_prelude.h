@@ -0,0 +1,37 @@
+/*
+ * Force-included ahead of every simulated source file (-include).
+ *
+ * lcd_bsp.h and home_assistant.h pull in the ESP-IDF panel drivers and
+ * ArduinoHA. Their include guards are claimed here and the few functions the
+ * UI modules call from them are declared instead; sim_stubs.cpp implements them.
+ */
+#ifndef SIM_PRELUDE_H
+#define SIM_PRELUDE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_events.h"
+
+#define LCD_BSP_H
+#define HOME_ASSISTANT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void lcd_display_sleep(void);
+void lcd_display_wake(void);
+bool lcd_display_is_awake(void);
+#ifdef __cplusplus
+}
+
+void ha_init();
+net_status_t ha_get_net_status();
+void ha_set_machine_power(bool state);
+void ha_set_preinfusion_mode(int8_t mode_index);
+void ha_set_target_temperature(float temp);
+void ha_set_steam_power(int8_t power);
+void ha_set_preinfusion_time(float time);
+void ha_trigger_backflush();
+#endif
+
+#endif // SIM_PRELUDE_H
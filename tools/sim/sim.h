@@ -0,0 +1,33 @@
+/*
+ * Simulator internals shared by sim_main.cpp and sim_stubs.cpp.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// Virtual clock. millis(), esp_timer_get_time() and the FreeRTOS timer
+// shims all read it; only the benchmark loop advances it.
+uint64_t sim_now_us();
+void sim_clock_advance_us(uint64_t us);
+
+// One knob detent (-1 left, +1 right), delivered through the callbacks
+// encoder_init() registered. The encoder derives its speed from the virtual
+// clock, so advance it between detents.
+void sim_knob_detent(int direction);
+
+// Simulated BLE round trip from write_target_weight() to the confirmation
+#define SIM_BLE_WRITE_RTT_MS 120
+
+typedef struct {
+    unsigned long writes;       // write_target_weight() calls
+    unsigned long prepares;     // ble_prepare_write() calls
+    unsigned long ha_commands;  // ha_set_* / ha_trigger_backflush() calls
+    unsigned long sleeps;       // lcd_display_sleep() calls
+    int8_t last_written;
+} sim_stub_stats_t;
+
+const sim_stub_stats_t* sim_stub_stats();
+void sim_stub_stats_reset();
+
+#endif // SIM_H
@@ -0,0 +1,405 @@
+/*
+ * Host benchmark for the shotStopper UI.
+ *
+ * Runs the real lvgl_display.cpp, lvgl_xml_loader.cpp, encoder.cpp and
+ * app_events.cpp against a headless LVGL display on a virtual clock, replays
+ * scripted input (knob spins, preset taps, swipes, HA updates) and reports
+ * per-frame lv_timer_handler() time, flushed bytes and LVGL heap use, plus
+ * how long the two screens take to build from the op streams and from XML.
+ *
+ * Times are host wall-clock times, so compare them between runs on the same
+ * machine. Not yet run against a real LVGL build (see README.md), so none of
+ * the reported numbers has been checked against the device.
+ *
+ * Usage: shotstopper_sim [--iterations N] [--max-p95-ms MS] [--max-lv-mem-kb KB]
+ * Exits with 1 if a limit is exceeded.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdlib.h>
+#include "sim.h"
+#include "lcd_config.h"
+#include "lvgl_display.h"
+#include "lvgl_xml_loader.h"
+#include "encoder.h"
+#include "app_log.h"
+#include "ui/ui_screen_ops.h"
+#include "ui/ui_xml_strings.h"
+
+#define SIM_STEP_MS 5                 // Virtual time per loop iteration
+#define SIM_SETTLE_MS 4000            // Boot settle: first frame plus the HA screen prebuild
+#define SIM_LOAD_ITERATIONS 200       // Default screen builds per loader for the load benchmark
+#define SIM_TAP_HOLD_MS 80            // Shorter than LVGL's long-press time
+#define SIM_SWIPE_MS 150
+#define SIM_SCREEN_ANIM_MS 400        // lv_scr_load_anim() time plus a margin
+
+// Untouched screen areas to start swipes from (see ui/*.xml)
+#define SIM_SWIPE_X 185
+#define SIM_SHOT_STOPPER_SWIPE_Y0 200
+#define SIM_HA_SWIPE_Y0 165
+#define SIM_SWIPE_DISTANCE 150
+
+// Centre of ha_temp_cont (align="center" x="-85" y="30")
+#define SIM_HA_TEMP_X (EXAMPLE_LCD_H_RES / 2 - 85)
+#define SIM_HA_TEMP_Y (EXAMPLE_LCD_V_RES / 2 + 30)
+
+extern lv_obj_t* preset_btns[3]; // lvgl_display.cpp
+
+// --- Headless display ---
+
+static lv_display_t* disp = NULL;
+static lv_indev_t* pointer = NULL;
+static lv_point_t pointer_pos = {0, 0};
+static bool pointer_pressed = false;
+
+// Counted for the scenario currently running
+static uint32_t flushes = 0;
+static uint32_t frames = 0;
+static uint64_t flushed_bytes = 0;
+
+static void sim_flush_cb(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+    (void)px_map;
+    flushes++;
+    flushed_bytes += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area) * (LCD_BIT_PER_PIXEL / 8);
+    if (lv_display_flush_is_last(display)) frames++;
+    lv_display_flush_ready(display);
+}
+
+// Same rounding as example_lvgl_rounder_cb(), so flushed areas match the device
+static void sim_rounder_cb(lv_event_t* e) {
+    lv_area_t* area = (lv_area_t*)lv_event_get_param(e);
+    area->x1 = area->x1 & ~1;
+    area->y1 = area->y1 & ~1;
+    area->x2 = (area->x2 & ~1) + 1;
+    area->y2 = (area->y2 & ~1) + 1;
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+    area->x1 = 0;
+    area->x2 = EXAMPLE_LCD_H_RES - 1;
+#endif
+}
+
+static void sim_pointer_cb(lv_indev_t* indev, lv_indev_data_t* data) {
+    (void)indev;
+    data->point = pointer_pos;
+    data->state = pointer_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    if (pointer_pressed) reset_inactivity_timer(); // Like example_lvgl_touch_cb()
+}
+
+static uint32_t sim_tick_cb(void) {
+    return millis();
+}
+
+static void sim_display_init() {
+    lv_init();
+    lv_tick_set_cb(sim_tick_cb);
+
+    const size_t buf_size = EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t);
+    void* buf1 = malloc(buf_size);
+    void* buf2 = malloc(buf_size);
+    disp = lv_display_create(EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES);
+    lv_display_set_flush_cb(disp, sim_flush_cb);
+#if LCD_RENDER_MODE == LCD_RENDER_PSRAM_DIRECT
+    lv_display_set_buffers(disp, buf1, buf2, buf_size, LV_DISPLAY_RENDER_MODE_DIRECT);
+#else
+    lv_display_set_buffers(disp, buf1, buf2, buf_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+#endif
+    lv_display_add_event_cb(disp, sim_rounder_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+
+    pointer = lv_indev_create();
+    lv_indev_set_type(pointer, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(pointer, sim_pointer_cb);
+    lv_indev_set_display(pointer, disp);
+}
+
+// --- Measurement ---
+
+typedef std::chrono::steady_clock wall_clock;
+
+static double elapsed_us(wall_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(wall_clock::now() - start).count();
+}
+
+typedef struct {
+    const char* name;
+    std::vector<double> frame_us; // lv_timer_handler() time of cycles that rendered
+    double idle_us;               // Total time of cycles that didn't
+    uint32_t cycles;
+    uint32_t frames;
+    uint32_t flushes;
+    uint64_t flushed_bytes;
+    uint32_t lv_max_used;         // LVGL heap peak since boot
+    uint8_t lv_frag_pct;
+    unsigned long ble_writes;
+    unsigned long ha_commands;
+} scenario_result_t;
+
+static scenario_result_t* current = NULL;
+
+// One LVGL task cycle, as in example_lvgl_port_task()
+static void sim_cycle() {
+    sim_clock_advance_us(SIM_STEP_MS * 1000);
+    sim_timers_run();
+    lvgl_display_process_events();
+
+    uint32_t frames_before = frames;
+    wall_clock::time_point start = wall_clock::now();
+    lv_timer_handler();
+    double us = elapsed_us(start);
+
+    if (!current) return;
+    current->cycles++;
+    if (frames != frames_before) current->frame_us.push_back(us);
+    else current->idle_us += us;
+}
+
+static void sim_run_ms(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += SIM_STEP_MS) sim_cycle();
+}
+
+static void scenario_begin(scenario_result_t* r, const char* name) {
+    *r = scenario_result_t();
+    r->name = name;
+    current = r;
+    frames = 0;
+    flushes = 0;
+    flushed_bytes = 0;
+    sim_stub_stats_reset();
+}
+
+static void scenario_end(scenario_result_t* r) {
+    sim_run_ms(500); // Let animations and the write confirmation finish
+    r->frames = frames;
+    r->flushes = flushes;
+    r->flushed_bytes = flushed_bytes;
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    r->lv_max_used = mon.max_used;
+    r->lv_frag_pct = mon.frag_pct;
+    r->ble_writes = sim_stub_stats()->writes;
+    r->ha_commands = sim_stub_stats()->ha_commands;
+    current = NULL;
+}
+
+// --- Scripted input ---
+
+static void tap(int32_t x, int32_t y) {
+    pointer_pos.x = x;
+    pointer_pos.y = y;
+    pointer_pressed = true;
+    sim_run_ms(SIM_TAP_HOLD_MS);
+    pointer_pressed = false;
+    sim_run_ms(100);
+}
+
+static void tap_obj(lv_obj_t* obj) {
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    tap((coords.x1 + coords.x2) / 2, (coords.y1 + coords.y2) / 2);
+}
+
+static void swipe(int32_t x, int32_t y0, int32_t y1) {
+    pointer_pos.x = x;
+    pointer_pos.y = y0;
+    pointer_pressed = true;
+    for (uint32_t t = 0; t <= SIM_SWIPE_MS; t += SIM_STEP_MS) {
+        pointer_pos.y = y0 + (y1 - y0) * (int32_t)t / SIM_SWIPE_MS;
+        sim_cycle();
+    }
+    pointer_pressed = false;
+    sim_run_ms(SIM_SCREEN_ANIM_MS);
+}
+
+// detents at a steady rate; negative turns left
+static void knob_spin(int detents, uint32_t interval_ms) {
+    for (int i = 0; i < abs(detents); i++) {
+        sim_knob_detent(detents < 0 ? -1 : 1);
+        sim_run_ms(interval_ms);
+    }
+}
+
+// --- Scenarios ---
+
+static void scenario_knob(scenario_result_t* r) {
+    scenario_begin(r, "knob_spin");
+    knob_spin(12, 120);   // Slow, one gram per detent
+    sim_run_ms(1200);     // Debounce write and confirmation
+    knob_spin(40, 30);    // Fast, accelerated
+    knob_spin(-20, 40);
+    sim_run_ms(1200);
+    scenario_end(r);
+}
+
+static void scenario_presets(scenario_result_t* r) {
+    scenario_begin(r, "presets");
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 3; i++) {
+            tap_obj(preset_btns[i]);
+            sim_run_ms(1200);
+        }
+    }
+    scenario_end(r);
+}
+
+static void scenario_swipes(scenario_result_t* r) {
+    scenario_begin(r, "swipes");
+    for (int i = 0; i < 5; i++) {
+        swipe(SIM_SWIPE_X, SIM_SHOT_STOPPER_SWIPE_Y0, SIM_SHOT_STOPPER_SWIPE_Y0 - SIM_SWIPE_DISTANCE);
+        swipe(SIM_SWIPE_X, SIM_HA_SWIPE_Y0, SIM_HA_SWIPE_Y0 + SIM_SWIPE_DISTANCE);
+    }
+    scenario_end(r);
+}
+
+static void scenario_ha(scenario_result_t* r) {
+    scenario_begin(r, "ha_controls");
+    swipe(SIM_SWIPE_X, SIM_SHOT_STOPPER_SWIPE_Y0, SIM_SHOT_STOPPER_SWIPE_Y0 - SIM_SWIPE_DISTANCE);
+    tap(SIM_HA_TEMP_X, SIM_HA_TEMP_Y); // Select the temperature
+    knob_spin(30, 30);
+    knob_spin(-10, 80);
+    // Bursts of HA state pushes, several per UI cycle
+    for (int i = 0; i < 50; i++) {
+        app_events_post_float(APP_EVT_HA_TEMPERATURE, 90.0f + (i % 8) * 0.5f);
+        app_events_post_float(APP_EVT_HA_TEMPERATURE, 90.0f + (i % 8) * 0.5f + 0.1f);
+        app_events_post_int(APP_EVT_HA_STEAM_POWER, 1 + i % 3);
+        app_events_post_bool(APP_EVT_HA_POWER, i & 1);
+        sim_run_ms(20);
+    }
+    swipe(SIM_SWIPE_X, SIM_HA_SWIPE_Y0, SIM_HA_SWIPE_Y0 + SIM_SWIPE_DISTANCE);
+    scenario_end(r);
+}
+
+// --- Screen build benchmark ---
+
+typedef struct {
+    const char* name;
+    double avg_us;
+    double max_us;
+    uint32_t lv_bytes; // LVGL heap taken by one built screen
+} load_result_t;
+
+static load_result_t bench_load(const char* name, int iterations, const lvgl_ui_op_t* ops, uint16_t op_count,
+                                uint16_t obj_count, const char* xml) {
+    load_result_t r = {name, 0, 0, 0};
+    for (int i = 0; i < iterations; i++) {
+        lv_mem_monitor_t before, after;
+        lv_mem_monitor(&before);
+        lvgl_ui_index_t index = {};
+        wall_clock::time_point start = wall_clock::now();
+        lv_obj_t* screen = lv_obj_create(NULL);
+        if (ops) {
+            lvgl_ui_index_reserve(&index, obj_count);
+            lvgl_ui_load_ops(ops, op_count, screen, &index);
+        } else {
+            lvgl_xml_load_from_string(xml, screen, &index);
+        }
+        double us = elapsed_us(start);
+        lv_mem_monitor(&after);
+        r.avg_us += us / iterations;
+        r.max_us = std::max(r.max_us, us);
+        r.lv_bytes = before.free_size - after.free_size;
+        lvgl_ui_index_free(&index);
+        lv_obj_delete(screen);
+    }
+    return r;
+}
+
+// --- Report ---
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static void print_scenario(const scenario_result_t* r) {
+    double sum = 0, max = 0;
+    for (double us : r->frame_us) {
+        sum += us;
+        max = std::max(max, us);
+    }
+    double avg = r->frame_us.empty() ? 0 : sum / r->frame_us.size();
+    printf("%-12s %6u %8.3f %8.3f %8.3f %8.2f %7u %8.1f %7.1f %4u%% %5lu %5lu\n",
+           r->name, r->frames, avg / 1000, percentile(r->frame_us, 0.95) / 1000, max / 1000,
+           r->cycles > r->frame_us.size() ? r->idle_us / (r->cycles - r->frame_us.size()) / 1000 : 0.0,
+           r->flushes, r->flushed_bytes / 1024.0, r->lv_max_used / 1024.0, (unsigned)r->lv_frag_pct,
+           r->ble_writes, r->ha_commands);
+}
+
+int main(int argc, char** argv) {
+    int iterations = SIM_LOAD_ITERATIONS;
+    double max_p95_ms = 0;
+    double max_lv_mem_kb = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-p95-ms") == 0 && i + 1 < argc) {
+            max_p95_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-lv-mem-kb") == 0 && i + 1 < argc) {
+            max_lv_mem_kb = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--iterations N] [--max-p95-ms MS] [--max-lv-mem-kb KB]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    app_log_init();
+    sim_display_init();
+    encoder_init();
+
+    scenario_result_t boot;
+    scenario_begin(&boot, "boot");
+    wall_clock::time_point start = wall_clock::now();
+    lvgl_display_init();
+    double init_us = elapsed_us(start);
+    sim_run_ms(SIM_SETTLE_MS);
+    scenario_end(&boot);
+
+    printf("shotStopper UI benchmark: render mode %d (%d-line buffers), %d ms cycles\n",
+           LCD_RENDER_MODE, EXAMPLE_LVGL_BUF_HEIGHT, SIM_STEP_MS);
+    printf("lvgl_display_init: %.3f ms\n\n", init_us / 1000);
+
+    load_result_t loads[] = {
+        bench_load("shot_stopper ops", iterations, shot_stopper_screen_ops, SHOT_STOPPER_SCREEN_OP_COUNT,
+                   SHOT_STOPPER_SCREEN_OBJ_COUNT, NULL),
+        bench_load("shot_stopper xml", iterations, NULL, 0, 0, shot_stopper_screen_xml),
+        bench_load("ha ops", iterations, home_assistant_screen_ops, HOME_ASSISTANT_SCREEN_OP_COUNT,
+                   HOME_ASSISTANT_SCREEN_OBJ_COUNT, NULL),
+        bench_load("ha xml", iterations, NULL, 0, 0, home_assistant_screen_xml),
+    };
+    printf("%-18s %9s %9s %9s   (%d builds each)\n", "screen build", "avg_ms", "max_ms", "lv_KB", iterations);
+    for (const load_result_t& l : loads) {
+        printf("%-18s %9.3f %9.3f %9.1f\n", l.name, l.avg_us / 1000, l.max_us / 1000, l.lv_bytes / 1024.0);
+    }
+    printf("\n");
+
+    scenario_result_t results[4];
+    scenario_knob(&results[0]);
+    scenario_presets(&results[1]);
+    scenario_swipes(&results[2]);
+    scenario_ha(&results[3]);
+
+    printf("%-12s %6s %8s %8s %8s %8s %7s %8s %7s %5s %5s %5s\n", "scenario", "frames", "avg_ms", "p95_ms",
+           "max_ms", "idle_ms", "flushes", "flush_KB", "lv_KB", "frag", "ble", "ha");
+    print_scenario(&boot);
+    for (const scenario_result_t& r : results) print_scenario(&r);
+    printf("\nEvent bus posts collapsed: %lu\n", app_events_collapsed());
+
+    int failed = 0;
+    for (const scenario_result_t& r : results) {
+        double p95_ms = percentile(r.frame_us, 0.95) / 1000;
+        if (max_p95_ms > 0 && p95_ms > max_p95_ms) {
+            printf("FAIL: %s p95 frame time %.3f ms > %.3f ms\n", r.name, p95_ms, max_p95_ms);
+            failed = 1;
+        }
+        if (max_lv_mem_kb > 0 && r.lv_max_used / 1024.0 > max_lv_mem_kb) {
+            printf("FAIL: %s LVGL heap peak %.1f KB > %.1f KB\n", r.name, r.lv_max_used / 1024.0, max_lv_mem_kb);
+            failed = 1;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,242 @@
+/*
+ * Host stand-ins for the hardware and network modules the UI links against:
+ * ble_client, home_assistant, iot_knob, backlight, panel sleep, settings,
+ * telemetry and app_log. They keep just enough state for the UI code to
+ * behave as on the device and count calls so the benchmark can report them.
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <vector>
+#include "sim.h"
+#include "app_log.h"
+#include "ble_client.h"
+#include "settings.h"
+#include "telemetry.h"
+#include "lcd_bl_pwm_bsp.h"
+#include "bidi_switch_knob.h"
+
+SimSerial Serial;
+
+static sim_stub_stats_t stats;
+
+const sim_stub_stats_t* sim_stub_stats() {
+    return &stats;
+}
+
+void sim_stub_stats_reset() {
+    stats = sim_stub_stats_t();
+}
+
+// --- Clock ---
+
+static uint64_t now_us = 0;
+
+uint64_t sim_now_us() {
+    return now_us;
+}
+
+void sim_clock_advance_us(uint64_t us) {
+    now_us += us;
+}
+
+unsigned long millis(void) {
+    return (unsigned long)(now_us / 1000);
+}
+
+void delay(uint32_t ms) {
+    now_us += (uint64_t)ms * 1000;
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)now_us;
+}
+
+// --- FreeRTOS software timers ---
+
+struct sim_timer {
+    const char* name;
+    TickType_t period;
+    bool auto_reload;
+    TimerCallbackFunction_t callback;
+    bool active;
+    uint64_t due_us;
+};
+
+static std::vector<sim_timer*> timers;
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* id,
+                           TimerCallbackFunction_t callback) {
+    (void)id;
+    sim_timer* t = new sim_timer{name, period, auto_reload != pdFALSE, callback, false, 0};
+    timers.push_back(t);
+    return t;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait) {
+    (void)wait;
+    if (!timer) return pdFAIL;
+    timer->active = true;
+    timer->due_us = now_us + (uint64_t)timer->period * 1000;
+    return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait) {
+    return xTimerReset(timer, wait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait) {
+    (void)wait;
+    if (!timer) return pdFAIL;
+    timer->active = false;
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+    return timer && timer->active ? pdTRUE : pdFALSE;
+}
+
+void sim_timers_run(void) {
+    for (size_t i = 0; i < timers.size(); i++) {
+        sim_timer* t = timers[i];
+        if (!t->active || t->due_us > now_us) continue;
+        if (t->auto_reload) t->due_us += (uint64_t)t->period * 1000;
+        else t->active = false;
+        t->callback(t);
+    }
+}
+
+// --- app_log: straight to stdout, filtered like the device build ---
+
+static int log_level = APP_LOG_LEVEL_WARN; // Keep benchmark output readable
+
+void app_log_init(void) {
+    const char* env = getenv("SIM_LOG_LEVEL");
+    if (env) log_level = atoi(env);
+}
+
+void app_log_write(int level, const char* fmt, ...) {
+    if (level > log_level) return;
+    static const char LEVELS[] = "?EWIDV";
+    printf("[%lu] %c ", millis(), LEVELS[level <= APP_LOG_LEVEL_VERBOSE ? level : 0]);
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+unsigned long app_log_dropped(void) {
+    return 0;
+}
+
+// --- ble_client: a stopper that confirms every write after SIM_BLE_WRITE_RTT_MS ---
+
+int8_t target_weight = 36;
+static TimerHandle_t ble_rtt_timer = NULL;
+
+static void ble_rtt_timer_cb(TimerHandle_t timer) {
+    (void)timer;
+    app_events_post_int(APP_EVT_WEIGHT_CONFIRMED, stats.last_written);
+}
+
+void write_target_weight(int8_t weight) {
+    if (ble_rtt_timer == NULL) {
+        ble_rtt_timer = xTimerCreate("simBleRtt", pdMS_TO_TICKS(SIM_BLE_WRITE_RTT_MS), pdFALSE, NULL, ble_rtt_timer_cb);
+    }
+    stats.writes++;
+    stats.last_written = weight;
+    xTimerReset(ble_rtt_timer, 0);
+}
+
+void ble_prepare_write() {
+    stats.prepares++;
+}
+
+bool ble_is_connected() {
+    return true;
+}
+
+// --- home_assistant: accepts every command, never connects ---
+
+net_status_t ha_get_net_status() {
+    return NET_STATUS_OFFLINE;
+}
+
+void ha_set_machine_power(bool state) { (void)state; stats.ha_commands++; }
+void ha_set_preinfusion_mode(int8_t mode_index) { (void)mode_index; stats.ha_commands++; }
+void ha_set_target_temperature(float temp) { (void)temp; stats.ha_commands++; }
+void ha_set_steam_power(int8_t power) { (void)power; stats.ha_commands++; }
+void ha_set_preinfusion_time(float time) { (void)time; stats.ha_commands++; }
+void ha_trigger_backflush() { stats.ha_commands++; }
+
+// --- Backlight and panel ---
+
+static bool display_awake = true;
+
+void lcd_bl_pwm_bsp_init(uint16_t duty) { (void)duty; }
+void setUpdutySubdivide(uint16_t duty) { (void)duty; }
+
+void lcd_display_sleep(void) {
+    if (display_awake) stats.sleeps++;
+    display_awake = false;
+}
+
+void lcd_display_wake(void) {
+    display_awake = true;
+}
+
+bool lcd_display_is_awake(void) {
+    return display_awake;
+}
+
+// --- Settings: RAM only ---
+
+static int8_t setting_i8[SETTING_COUNT];
+static bool setting_present[SETTING_COUNT];
+
+bool settings_is_set(setting_id_t id) {
+    return (unsigned)id < SETTING_COUNT && setting_present[id];
+}
+
+int8_t settings_get_i8(setting_id_t id, int8_t def) {
+    return settings_is_set(id) ? setting_i8[id] : def;
+}
+
+void settings_set_i8(setting_id_t id, int8_t value) {
+    if ((unsigned)id >= SETTING_COUNT) return;
+    setting_i8[id] = value;
+    setting_present[id] = true;
+}
+
+void settings_flush() {
+}
+
+// --- Telemetry: the benchmark samples the LVGL heap itself ---
+
+void telemetry_sample_lvgl() {
+}
+
+// --- iot_knob: detents come from sim_knob_detent() ---
+
+static knob_cb_t knob_cbs[KNOB_EVENT_MAX];
+static int knob_instance;
+
+knob_handle_t iot_knob_create(const knob_config_t* config) {
+    (void)config;
+    return &knob_instance;
+}
+
+esp_err_t iot_knob_register_cb(knob_handle_t knob_handle, knob_event_t event, knob_cb_t cb, void* usr_data) {
+    (void)knob_handle;
+    (void)usr_data;
+    if (event >= KNOB_EVENT_MAX) return ESP_ERR_INVALID_ARG;
+    knob_cbs[event] = cb;
+    return ESP_OK;
+}
+
+void sim_knob_detent(int direction) {
+    knob_event_t event = direction < 0 ? KNOB_LEFT : KNOB_RIGHT;
+    if (knob_cbs[event]) knob_cbs[event](&knob_instance, NULL);
+}
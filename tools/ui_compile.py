@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""
+Compiles the UI screen XML files in ui/ into C headers.
+
+The XML files in ui/ are the editable source of truth. This script generates:
+  - ui/ui_xml_strings.h  The XML embedded as strings (runtime parser fallback)
+  - ui/ui_screen_ops.h   A pre-resolved widget-op stream per screen, executed
+                         by lvgl_ui_load_ops() in lvgl_xml_loader.cpp
+
+Enums, colors and fonts are resolved here, at build time, so the device does
+no string parsing when it builds a screen. The op order per element matches
+create_object_from_xml() so both paths produce the same widget tree.
+
+Usage (from the repository root):
+    python3 tools/ui_compile.py
+"""
+
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+UI_DIR = os.path.join(ROOT, "ui")
+
+# Screens in the order they appear in the generated headers
+SCREENS = ["shot_stopper_screen", "home_assistant_screen"]
+
+WIDGET_TYPES = {
+    "screen": "LVGL_UI_OBJ",
+    "obj": "LVGL_UI_OBJ",
+    "container": "LVGL_UI_OBJ",
+    "label": "LVGL_UI_LABEL",
+    "btn": "LVGL_UI_BTN",
+}
+
+ALIGNS = {
+    "top_mid": "LV_ALIGN_TOP_MID",
+    "top_left": "LV_ALIGN_TOP_LEFT",
+    "top_right": "LV_ALIGN_TOP_RIGHT",
+    "center": "LV_ALIGN_CENTER",
+    "bottom_mid": "LV_ALIGN_BOTTOM_MID",
+    "bottom_left": "LV_ALIGN_BOTTOM_LEFT",
+    "bottom_right": "LV_ALIGN_BOTTOM_RIGHT",
+}
+
+FONTS = {
+    "montserrat_16": "&lv_font_montserrat_16",
+    "montserrat_24": "&lv_font_montserrat_24",
+    "montserrat_48": "LVGL_UI_FONT_MONTSERRAT_48",  # Falls back to 24 if 48 is not enabled
+}
+
+FLEX_FLOWS = {
+    "row": "LV_FLEX_FLOW_ROW",
+    "column": "LV_FLEX_FLOW_COLUMN",
+}
+
+FLEX_ALIGNS = {
+    "start": "LV_FLEX_ALIGN_START",
+    "end": "LV_FLEX_ALIGN_END",
+    "center": "LV_FLEX_ALIGN_CENTER",
+    "space_evenly": "LV_FLEX_ALIGN_SPACE_EVENLY",
+    "space_around": "LV_FLEX_ALIGN_SPACE_AROUND",
+    "space_between": "LV_FLEX_ALIGN_SPACE_BETWEEN",
+}
+
+
+class CompileError(Exception):
+    pass
+
+
+def fnv1a(name):
+    """32-bit FNV-1a, identical to lvgl_ui_hash() / lvgl_ui_hash_str()."""
+    h = 2166136261
+    for b in name.encode("utf-8"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def c_string(text):
+    """Returns text as a C string literal."""
+    out = text.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n")
+    return "\"" + out + "\""
+
+
+def parse_color(value, where):
+    """Resolves '#RRGGBB' or '#RGB' to a 0xRRGGBB literal."""
+    if not value.startswith("#") or len(value) not in (4, 7):
+        raise CompileError("%s: bad color '%s'" % (where, value))
+    digits = value[1:]
+    if len(digits) == 3:
+        digits = "".join(c * 2 for c in digits)
+    int(digits, 16)  # Validate
+    return "0x" + digits.upper()
+
+
+def lookup(table, value, what, where):
+    if value not in table:
+        raise CompileError("%s: unknown %s '%s'" % (where, what, value))
+    return table[value]
+
+
+def op(kind, arg="0", x=0, y=0, ptr="NULL", value="0"):
+    return "    {%s, %s, %s, %s, %s, %s}," % (kind, arg, x, y, ptr, value)
+
+
+def compile_element(elem, ops, names, path):
+    where = "%s <%s name=%s>" % (path, elem.tag, elem.get("name", "?"))
+    a = elem.attrib
+
+    widget = WIDGET_TYPES.get(elem.tag, "LVGL_UI_OBJ")  # Unknown tags become plain objects, like the runtime
+    name = a.get("name")
+    ops.append(op("LVGL_UI_OP_BEGIN", widget, ptr=c_string(name) if name else "NULL",
+                  value="0x%08X" % fnv1a(name) if name else "0"))
+    if name:
+        if name in names:
+            raise CompileError("%s: duplicate name '%s'" % (where, name))
+        names.append(name)
+
+    if "width" in a and "height" in a:
+        ops.append(op("LVGL_UI_OP_SIZE", x=int(a["width"]), y=int(a["height"])))
+    if "align" in a:
+        ops.append(op("LVGL_UI_OP_ALIGN", lookup(ALIGNS, a["align"], "align", where),
+                      x=int(a.get("x", 0)), y=int(a.get("y", 0))))
+    if "bg_color" in a:
+        ops.append(op("LVGL_UI_OP_BG_COLOR", value=parse_color(a["bg_color"], where)))
+    if "text_color" in a:
+        ops.append(op("LVGL_UI_OP_TEXT_COLOR", value=parse_color(a["text_color"], where)))
+    if "font" in a:
+        ops.append(op("LVGL_UI_OP_FONT", ptr=lookup(FONTS, a["font"], "font", where)))
+    if "text" in a and elem.tag == "label":
+        ops.append(op("LVGL_UI_OP_TEXT", "1", ptr=c_string(a["text"])))  # 1 = center in parent
+    if a.get("scrollable") == "false":
+        ops.append(op("LVGL_UI_OP_CLEAR_FLAG", value="LV_OBJ_FLAG_SCROLLABLE"))
+    if a.get("remove_style") == "true":
+        ops.append(op("LVGL_UI_OP_REMOVE_STYLE_ALL"))
+    if a.get("hidden") == "true":
+        ops.append(op("LVGL_UI_OP_ADD_FLAG", value="LV_OBJ_FLAG_HIDDEN"))
+    if a.get("checkable") == "true":
+        ops.append(op("LVGL_UI_OP_ADD_FLAG", value="LV_OBJ_FLAG_CHECKABLE"))
+    if a.get("clickable") == "true":
+        ops.append(op("LVGL_UI_OP_ADD_FLAG", value="LV_OBJ_FLAG_CLICKABLE"))
+    if "flex_flow" in a and a["flex_flow"] in FLEX_FLOWS:
+        ops.append(op("LVGL_UI_OP_FLEX_FLOW", FLEX_FLOWS[a["flex_flow"]]))
+    if "flex_align" in a:
+        parts = [p.strip() for p in a["flex_align"].split(",")]
+        while len(parts) < 3:
+            parts.append("center")
+        main, cross, track = (lookup(FLEX_ALIGNS, p, "flex_align", where) for p in parts[:3])
+        ops.append(op("LVGL_UI_OP_FLEX_ALIGN", main, x=cross, y=track))
+
+    # Text content between the tags (labels only), as the runtime parser does
+    text = (elem.text or "").strip()
+    if text and elem.tag == "label":
+        ops.append(op("LVGL_UI_OP_TEXT", "0", ptr=c_string(text)))
+
+    for child in elem:
+        compile_element(child, ops, names, path)
+
+    ops.append(op("LVGL_UI_OP_END"))
+
+
+def compile_screen(screen):
+    path = os.path.join(UI_DIR, screen + ".xml")
+    with open(path, "r", encoding="utf-8") as f:
+        source = f.read()
+    try:
+        root = ET.fromstring(source.encode("utf-8"))
+    except ET.ParseError as e:
+        raise CompileError("%s: %s" % (path, e))
+    ops = []
+    names = []
+    compile_element(root, ops, names, os.path.relpath(path, ROOT))
+    return source, ops, names
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path, "r", encoding="utf-8") as f:
+            if f.read() == content:
+                return False
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(content)
+    return True
+
+
+def generate(screens):
+    strings = [
+        "/*",
+        " * Embedded XML UI definitions for LVGL screens.",
+        " * GENERATED by tools/ui_compile.py from the ui/ screen XML - do not edit by hand.",
+        " * Used by the runtime XML parser when LVGL_UI_USE_COMPILED is 0.",
+        " */",
+        "",
+        "#ifndef UI_XML_STRINGS_H",
+        "#define UI_XML_STRINGS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+    ops_h = [
+        "/*",
+        " * Precompiled widget-op streams for the LVGL screens.",
+        " * GENERATED by tools/ui_compile.py from the ui/ screen XML - do not edit by hand.",
+        " * Executed by lvgl_ui_load_ops(); enums, colors and fonts are pre-resolved.",
+        " */",
+        "",
+        "#ifndef UI_SCREEN_OPS_H",
+        "#define UI_SCREEN_OPS_H",
+        "",
+        "#include \"../lvgl_xml_loader.h\"",
+        "",
+    ]
+
+    for screen, (source, ops, names) in screens:
+        strings.append("// %s.xml" % screen)
+        strings.append("// Note: On ESP32, PROGMEM is not needed as strings are already in flash")
+        strings.append("const char %s_xml[] = " % screen)
+        lines = source.splitlines(True)
+        for i, line in enumerate(lines):
+            strings.append(c_string(line) + (";" if i == len(lines) - 1 else ""))
+        strings.append("")
+
+        macro = screen.upper()
+        ops_h.append("// %s.xml: %d ops, %d named objects" % (screen, len(ops), len(names)))
+        ops_h.append("#define %s_OBJ_COUNT %d" % (macro, len(names)))
+        ops_h.append("static const lvgl_ui_op_t %s_ops[] = {" % screen)
+        ops_h.extend(ops)
+        ops_h.append("};")
+        ops_h.append("#define %s_OP_COUNT (sizeof(%s_ops) / sizeof(%s_ops[0]))" % (macro, screen, screen))
+        ops_h.append("")
+
+    strings.append("#endif // UI_XML_STRINGS_H")
+    ops_h.append("#endif // UI_SCREEN_OPS_H")
+
+    changed = []
+    if write_if_changed(os.path.join(UI_DIR, "ui_xml_strings.h"), "\n".join(strings) + "\n"):
+        changed.append("ui/ui_xml_strings.h")
+    if write_if_changed(os.path.join(UI_DIR, "ui_screen_ops.h"), "\n".join(ops_h) + "\n"):
+        changed.append("ui/ui_screen_ops.h")
+    return changed
+
+
+def main():
+    try:
+        screens = [(s, compile_screen(s)) for s in SCREENS]
+    except (CompileError, ValueError) as e:
+        print("ui_compile: error: %s" % e, file=sys.stderr)
+        return 1
+    changed = generate(screens)
+    for path in changed:
+        print("ui_compile: wrote %s" % path)
+    if not changed:
+        print("ui_compile: up to date")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+/*
+ * Precompiled widget-op streams for the LVGL screens.
+ * GENERATED by tools/ui_compile.py from the ui/ screen XML - do not edit by hand.
+ * Executed by lvgl_ui_load_ops(); enums, colors and fonts are pre-resolved.
+ */
+
+#ifndef UI_SCREEN_OPS_H
+#define UI_SCREEN_OPS_H
+
+#include "../lvgl_xml_loader.h"
+
+// shot_stopper_screen.xml: 79 ops, 14 named objects
+#define SHOT_STOPPER_SCREEN_OBJ_COUNT 14
+static const lvgl_ui_op_t shot_stopper_screen_ops[] = {
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "screen_shot_stopper", 0xCCA9595E},
+    {LVGL_UI_OP_SIZE, 0, 360, 360, NULL, 0},
+    {LVGL_UI_OP_BG_COLOR, 0, 0, 0, NULL, 0x000000},
+    {LVGL_UI_OP_CLEAR_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_SCROLLABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ble_status_label", 0x74D9F148},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_MID, -20, 10, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0x808080},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "B", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "wifi_status_label", 0xBB59AD5E},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_MID, 20, 10, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0x808080},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "W", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "title_label", 0x28B4D598},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_MID, 0, 50, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "Target Weight (g)", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "weight_label", 0xA6BFD5A8},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_CENTER, 0, -30, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, LVGL_UI_FONT_MONTSERRAT_48, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "...", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "checkmark_label", 0x914AA0CF},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_CENTER, 0, 10, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0x00FF00},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "OK", 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_HIDDEN},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "preset_container", 0xF072569E},
+    {LVGL_UI_OP_SIZE, 0, 320, 80, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_BOTTOM_MID, 0, -60, NULL, 0},
+    {LVGL_UI_OP_REMOVE_STYLE_ALL, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_FLEX_FLOW, LV_FLEX_FLOW_ROW, 0, 0, NULL, 0},
+    {LVGL_UI_OP_FLEX_ALIGN, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_BTN, 0, 0, "preset_btn_0", 0x0BAB42FE},
+    {LVGL_UI_OP_SIZE, 0, 90, 60, NULL, 0},
+    {LVGL_UI_OP_BG_COLOR, 0, 0, 0, NULL, 0x808080},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "preset_label_0", 0xEFA01C34},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "36 g", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_BTN, 0, 0, "preset_btn_1", 0x0CAB4491},
+    {LVGL_UI_OP_SIZE, 0, 90, 60, NULL, 0},
+    {LVGL_UI_OP_BG_COLOR, 0, 0, 0, NULL, 0x808080},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "preset_label_1", 0xF0A01DC7},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "40 g", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_BTN, 0, 0, "preset_btn_2", 0x09AB3FD8},
+    {LVGL_UI_OP_SIZE, 0, 90, 60, NULL, 0},
+    {LVGL_UI_OP_BG_COLOR, 0, 0, 0, NULL, 0x808080},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "preset_label_2", 0xF1A01F5A},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_24, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "45 g", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "battery_label", 0x13C888EB},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_BOTTOM_MID, 0, -20, NULL, 0},
+    {LVGL_UI_OP_TEXT_COLOR, 0, 0, 0, NULL, 0xFFFFFF},
+    {LVGL_UI_OP_FONT, 0, 0, 0, &lv_font_montserrat_16, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "Batt: --%", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+};
+#define SHOT_STOPPER_SCREEN_OP_COUNT (sizeof(shot_stopper_screen_ops) / sizeof(shot_stopper_screen_ops[0]))
+
+// home_assistant_screen.xml: 61 ops, 13 named objects
+#define HOME_ASSISTANT_SCREEN_OBJ_COUNT 13
+static const lvgl_ui_op_t home_assistant_screen_ops[] = {
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "screen_ha", 0xF7D95D25},
+    {LVGL_UI_OP_SIZE, 0, 360, 360, NULL, 0},
+    {LVGL_UI_OP_BG_COLOR, 0, 0, 0, NULL, 0x343A40},
+    {LVGL_UI_OP_CLEAR_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_SCROLLABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_BTN, 0, 0, "ha_on_off_btn", 0x6F8F58EB},
+    {LVGL_UI_OP_SIZE, 0, 180, 50, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_MID, 0, 15, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CHECKABLE},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, NULL, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "P ON/OFF", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "ha_mode_cont", 0x6B569575},
+    {LVGL_UI_OP_SIZE, 0, 150, 60, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_LEFT, 20, 80, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ha_mode_label", 0x3C789875},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "Pre-brew", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "ha_preinf_time_cont", 0xC632CD7A},
+    {LVGL_UI_OP_SIZE, 0, 150, 80, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_TOP_RIGHT, -20, 80, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ha_preinf_time_label", 0x305D877C},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "0.8s", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "ha_temp_cont", 0xE19095A6},
+    {LVGL_UI_OP_SIZE, 0, 150, 80, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_CENTER, -85, 30, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ha_temp_label", 0x80D3B6C0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "93.0 C", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "ha_steam_cont", 0x5ABD219A},
+    {LVGL_UI_OP_SIZE, 0, 120, 80, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_CENTER, 85, 30, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ha_steam_label", 0xA0955E1C},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "Pwr: 3", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_BTN, 0, 0, "ha_backflush_cont", 0x0E98300F},
+    {LVGL_UI_OP_SIZE, 0, 180, 50, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_BOTTOM_RIGHT, -20, -15, NULL, 0},
+    {LVGL_UI_OP_ADD_FLAG, 0, 0, 0, NULL, LV_OBJ_FLAG_CLICKABLE},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, NULL, 0},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "R BACKFLUSH", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_OBJ, 0, 0, "last_shot_cont", 0xD7F92FEB},
+    {LVGL_UI_OP_SIZE, 0, 120, 50, NULL, 0},
+    {LVGL_UI_OP_ALIGN, LV_ALIGN_BOTTOM_LEFT, 20, -15, NULL, 0},
+    {LVGL_UI_OP_BEGIN, LVGL_UI_LABEL, 0, 0, "ha_last_shot_label", 0x1D157A1D},
+    {LVGL_UI_OP_TEXT, 1, 0, 0, "Last: 0.0s", 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+    {LVGL_UI_OP_END, 0, 0, 0, NULL, 0},
+};
+#define HOME_ASSISTANT_SCREEN_OP_COUNT (sizeof(home_assistant_screen_ops) / sizeof(home_assistant_screen_ops[0]))
+
+#endif // UI_SCREEN_OPS_H
@@ -1,6 +1,7 @@
 /*
  * Embedded XML UI definitions for LVGL screens.
- * These strings can be edited in the LVGL Online Editor and then embedded here.
+ * GENERATED by tools/ui_compile.py from the ui/ screen XML - do not edit by hand.
+ * Used by the runtime XML parser when LVGL_UI_USE_COMPILED is 0.
  */
 
 #ifndef UI_XML_STRINGS_H
@@ -8,12 +9,13 @@
 
 #include <Arduino.h>
 
-// Shot Stopper Screen XML
+// shot_stopper_screen.xml
 // Note: On ESP32, PROGMEM is not needed as strings are already in flash
 const char shot_stopper_screen_xml[] = 
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
 "<screen name=\"screen_shot_stopper\" width=\"360\" height=\"360\" bg_color=\"#000000\" scrollable=\"false\">\n"
-"  <label name=\"ble_status_label\" text=\"B\" align=\"top_mid\" y=\"10\" font=\"montserrat_24\" text_color=\"#808080\"/>\n"
+"  <label name=\"ble_status_label\" text=\"B\" align=\"top_mid\" x=\"-20\" y=\"10\" font=\"montserrat_24\" text_color=\"#808080\"/>\n"
+"  <label name=\"wifi_status_label\" text=\"W\" align=\"top_mid\" x=\"20\" y=\"10\" font=\"montserrat_24\" text_color=\"#808080\"/>\n"
 "  <label name=\"title_label\" text=\"Target Weight (g)\" align=\"top_mid\" y=\"50\" font=\"montserrat_24\" text_color=\"#FFFFFF\"/>\n"
 "  <label name=\"weight_label\" text=\"...\" align=\"center\" y=\"-30\" font=\"montserrat_48\" text_color=\"#FFFFFF\"/>\n"
 "  <label name=\"checkmark_label\" text=\"OK\" align=\"center\" y=\"10\" font=\"montserrat_24\" text_color=\"#00FF00\" hidden=\"true\"/>\n"
@@ -31,7 +33,8 @@ const char shot_stopper_screen_xml[] =
 "  <label name=\"battery_label\" text=\"Batt: --%\" align=\"bottom_mid\" y=\"-20\" font=\"montserrat_16\" text_color=\"#FFFFFF\"/>\n"
 "</screen>\n";
 
-// Home Assistant Screen XML
+// home_assistant_screen.xml
+// Note: On ESP32, PROGMEM is not needed as strings are already in flash
 const char home_assistant_screen_xml[] = 
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
 "<screen name=\"screen_ha\" width=\"360\" height=\"360\" bg_color=\"#343a40\" scrollable=\"false\">\n"
@@ -59,4 +62,3 @@ const char home_assistant_screen_xml[] =
 "</screen>\n";
 
 #endif // UI_XML_STRINGS_H
-